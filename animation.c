@@ -0,0 +1,169 @@
+#include <SDL2/SDL.h>
+#include "gameState.h"
+#include "items.h"
+#include "jobs.h"
+#include "timeline.h"
+
+// Blocks animated per job
+#define BLOCK_GRAIN 16
+
+// Shattering animation when player breaks a block
+void blockBreakAnimation(struct Particle *particle, const ushort index) {
+  const Num maxFall = NUM_MUL(MAX_GRAVITY, NUM(1.5f));
+
+  if (particle->velocity.x == 0) {
+    if (index == 0 || index == 2)
+      particle->velocity.x -= NUM_MUL(SPEED, NUM(1.2f));
+    else
+      particle->velocity.x += NUM_MUL(SPEED, NUM(1.2f));
+  }
+
+  if (index < 2 && particle->velocity.y < maxFall)
+    particle->velocity.y += GRAVITY;
+  else if (index >= 2 && particle->velocity.y < maxFall)
+    particle->velocity.y += NUM_MUL(GRAVITY, NUM(1.25f));
+
+  particle->rect.x += particle->velocity.x;
+  particle->rect.y += particle->velocity.y;
+}
+
+// Animate items comming out of the block
+void itemAnimation(Block *block, const Num tile) {
+  if (!block->item.free)
+    return;
+
+  if (itemBehaviors[block->item.type].powerUp) {
+    if (block->item.rect.y > block->initY - tile)
+      block->item.rect.y -= BLOCK_SPEED;
+    else
+      block->type = EMPTY;
+  }
+}
+
+// Holds the player in place while it grows
+bool transformSequence(GameState *state, Sequence *sequence) {
+  Player *player = &state->world.players[sequence->target];
+  SEQUENCE_BEGIN(sequence);
+  player->transforming = true;
+  player->velocity = (Velocity){0, 0};
+  SEQUENCE_WAIT(sequence, 1, XFORM_TICKS);
+  player->transforming = false;
+  player->tall = true;
+  SEQUENCE_END(sequence);
+}
+
+bool starSequence(GameState *state, Sequence *sequence) {
+  Player *player = &state->world.players[sequence->target];
+  SEQUENCE_BEGIN(sequence);
+  player->invincible = true;
+  SEQUENCE_WAIT(sequence, 1, STAR_TICKS);
+  player->invincible = false;
+  SEQUENCE_END(sequence);
+}
+
+// The pose after throwing a fireball
+bool firingSequence(GameState *state, Sequence *sequence) {
+  Player *player = &state->world.players[sequence->target];
+  SEQUENCE_BEGIN(sequence);
+  player->firing = true;
+  SEQUENCE_WAIT(sequence, 1, FIRING_TICKS);
+  player->firing = false;
+  SEQUENCE_END(sequence);
+}
+
+// The time after a hit where enemies cannot hurt the player again
+bool hurtSequence(GameState *state, Sequence *sequence) {
+  Player *player = &state->world.players[sequence->target];
+  SEQUENCE_BEGIN(sequence);
+  player->hurt = true;
+  SEQUENCE_WAIT(sequence, 1, HURT_TICKS);
+  player->hurt = false;
+  SEQUENCE_END(sequence);
+}
+
+// A block going up a quarter tile and back, after the player hits it
+bool bumpSequence(GameState *state, Sequence *sequence) {
+  Block *block = &state->world.blocks[sequence->target];
+  const Num top = block->initY - NUM(state->screen.tile) / 4;
+  SEQUENCE_BEGIN(sequence);
+  block->gotHit = true;
+  while (block->rect.y > top) {
+    block->rect.y -= BLOCK_SPEED;
+    SEQUENCE_YIELD(sequence, 1);
+  }
+
+  block->gotHit = false;
+  while (block->rect.y < block->initY) {
+    block->rect.y += BLOCK_SPEED;
+    SEQUENCE_YIELD(sequence, 2);
+  }
+  block->rect.y = block->initY;
+  SEQUENCE_END(sequence);
+}
+
+// A coin popping three tiles out of its block and falling back in
+bool coinSequence(GameState *state, Sequence *sequence) {
+  Block *block = &state->world.blocks[sequence->target];
+  Coin *coin = &block->coins[sequence->index];
+  const Num speed = BLOCK_SPEED * 3,
+            top = block->initY - NUM(state->screen.tile) * 3;
+  SEQUENCE_BEGIN(sequence);
+  coin->onAir = true;
+  while (coin->rect.y > top) {
+    coin->rect.y -= speed;
+    SEQUENCE_YIELD(sequence, 1);
+  }
+
+  coin->willFall = true;
+  while (coin->rect.y < block->initY) {
+    coin->rect.y += speed;
+    SEQUENCE_YIELD(sequence, 2);
+  }
+  coin->rect.y = block->initY;
+  coin->willFall = false;
+  coin->onAir = false;
+  SEQUENCE_END(sequence);
+}
+
+// Advances the animations of a range of blocks, each only touches its own
+static void animateBlocks(void *data,
+                          const uint chunk,
+                          const uint begin,
+                          const uint end) {
+  GameState *state = data;
+  World *world = &state->world;
+  const Num tile = NUM(state->screen.tile), h = NUM(state->screen.h);
+  (void)chunk;
+
+  for (uint i = begin; i < end; i++) {
+    Block *block = &world->blocks[i];
+
+    // Animating items
+    if (block->type != NOTHING) {
+      itemAnimation(block, tile);
+      const bool powerUp = itemBehaviors[block->item.type].powerUp;
+      if ((powerUp && block->item.free) || (!powerUp && !block->coinCount))
+        block->sprite = EMPTY_SPRITE;
+    }
+
+    if (!block->broken)
+      continue;
+
+    for (ushort j = 0; j < MAX_BLOCK_PARTICLES; j++) {
+      struct Particle *particle = &block->particles[j];
+      if (particle->rect.y < h)
+        blockBreakAnimation(particle, j);
+    }
+  }
+}
+
+// Advances every item and particle animation, and every sequence, by one
+// tick
+void animate(GameState *state) {
+  parallelFor(&state->jobs,
+              state->world.blocksLenght,
+              BLOCK_GRAIN,
+              animateBlocks,
+              state);
+  runSequences(state);
+}
@@ -0,0 +1,16 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include "gameState.h"
+
+void blockBreakAnimation(struct Particle *particle, const ushort index);
+void itemAnimation(Block *block, const Num tile);
+bool transformSequence(GameState *state, Sequence *sequence);
+bool starSequence(GameState *state, Sequence *sequence);
+bool firingSequence(GameState *state, Sequence *sequence);
+bool hurtSequence(GameState *state, Sequence *sequence);
+bool bumpSequence(GameState *state, Sequence *sequence);
+bool coinSequence(GameState *state, Sequence *sequence);
+void animate(GameState *state);
+
+#endif
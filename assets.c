@@ -0,0 +1,254 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_atomic.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_thread.h>
+#include <string.h>
+#include "assets.h"
+#include "gameState.h"
+#include "layer.h"
+#include "utils.h"
+
+// @return A copy of the surface flipped horizontally, in ARGB8888
+static SDL_Surface *mirrorSurface(SDL_Surface *surface) {
+  SDL_Surface *source =
+    SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+  if (!source)
+    return NULL;
+  SDL_Surface *mirrored = SDL_CreateRGBSurfaceWithFormat(
+    0, source->w, source->h, 32, SDL_PIXELFORMAT_ARGB8888);
+
+  if (mirrored) {
+    for (int y = 0; y < source->h; y++) {
+      const Uint32 *from =
+        (const Uint32 *)((Uint8 *)source->pixels + y * source->pitch);
+      Uint32 *to = (Uint32 *)((Uint8 *)mirrored->pixels + y * mirrored->pitch);
+      for (int x = 0; x < source->w; x++)
+        to[x] = from[source->w - 1 - x];
+    }
+  }
+  SDL_FreeSurface(source);
+  return mirrored;
+}
+
+static void decodeAsset(Asset *asset) {
+  // Any change from here on is read below, or noticed once it is decoded
+  SDL_AtomicSet(&asset->changed, 0);
+  SDL_RWops *file = SDL_RWFromFile(asset->path, "r");
+  if (file)
+    asset->surface = IMG_LoadTyped_RW(file, 1, "PNG");
+  if (asset->surface && asset->mirrored) {
+    asset->mirroredSurface = mirrorSurface(asset->surface);
+    if (!asset->mirroredSurface) {
+      SDL_FreeSurface(asset->surface);
+      asset->surface = NULL;
+    }
+  }
+
+  if (!file || !asset->surface) {
+    SDL_strlcpy(asset->error, SDL_GetError(), sizeof(asset->error));
+    SDL_AtomicSet(&asset->status, ASSET_FAILED);
+  } else
+    SDL_AtomicSet(&asset->status, ASSET_DECODED);
+}
+
+// Decodes every queued asset, then sleeps until more are queued
+static int loader(void *data) {
+  Assets *assets = data;
+
+  while (true) {
+    SDL_SemWait(assets->wake);
+    if (SDL_AtomicGet(&assets->quit))
+      return 0;
+
+    const int count = SDL_AtomicGet(&assets->count);
+    for (int i = 0; i < count; i++) {
+      if (SDL_AtomicGet(&assets->assets[i].status) == ASSET_QUEUED)
+        decodeAsset(&assets->assets[i]);
+    }
+  }
+}
+
+// Starts the loader thread, without it assets are decoded when requested
+void initAssets(GameState *state) {
+  Assets *assets = &state->assets;
+  SDL_AtomicSet(&assets->count, 0);
+  SDL_AtomicSet(&assets->quit, 0);
+
+  assets->wake = SDL_CreateSemaphore(0);
+  if (assets->wake)
+    assets->thread = SDL_CreateThread(loader, "loader", assets);
+  if (!assets->thread)
+    printf("Could not start the asset loader, loading on the main thread! "
+           "SDL_Error: %s\n",
+           SDL_GetError());
+}
+
+// Queues a PNG to be loaded into texture, which stays NULL until then.
+// Can be called at any time from the render thread.
+// @param path: The file, copied so it can be freed right after
+// @param texture: Where the texture is stored once it is uploaded
+// @param mirrored: Where to store a mirrored copy, or NULL for none
+void requestAsset(GameState *state,
+                  const char *path,
+                  SDL_Texture **texture,
+                  SDL_Texture **mirrored) {
+  Assets *assets = &state->assets;
+  const int index = SDL_AtomicGet(&assets->count);
+  if (index >= MAX_ASSETS) {
+    printf("Too many assets requested, %s is not loaded\n", path);
+    return;
+  }
+
+  Asset *asset = &assets->assets[index];
+  asset->path = catpath(state, path, "");
+  asset->texture = texture;
+  asset->mirrored = mirrored;
+  asset->surface = asset->mirroredSurface = NULL;
+  asset->error[0] = '\0';
+  SDL_AtomicSet(&asset->changed, 0);
+  SDL_AtomicSet(&asset->status, ASSET_QUEUED);
+
+  if (!assets->thread)
+    decodeAsset(asset);
+
+  // Publishing the count last, so the loader never sees a half made asset
+  SDL_AtomicSet(&assets->count, index + 1);
+  if (assets->thread)
+    SDL_SemPost(assets->wake);
+}
+
+// Drops what was decoded of an asset and decodes its file again
+static void requeueAsset(Assets *assets, Asset *asset) {
+  SDL_FreeSurface(asset->surface);
+  SDL_FreeSurface(asset->mirroredSurface);
+  asset->surface = asset->mirroredSurface = NULL;
+  SDL_AtomicSet(&asset->status, ASSET_QUEUED);
+  if (assets->thread)
+    SDL_SemPost(assets->wake);
+  else
+    decodeAsset(asset);
+}
+
+// Decodes an asset that was requested before again, after its file changed.
+// The old texture stays in use until the new one is uploaded.
+// @return false if no asset was loaded from path
+bool reloadAsset(GameState *state, const char *path) {
+  Assets *assets = &state->assets;
+  const int count = SDL_AtomicGet(&assets->count);
+
+  for (int i = 0; i < count; i++) {
+    Asset *asset = &assets->assets[i];
+    if (strcmp(asset->path, path))
+      continue;
+
+    // The loader may be reading the old file right now, so the asset is
+    // decoded again once it is done
+    if (SDL_AtomicGet(&asset->status) == ASSET_QUEUED)
+      SDL_AtomicSet(&asset->changed, 1);
+    else
+      requeueAsset(assets, asset);
+    return true;
+  }
+  return false;
+}
+
+// Turns decoded surfaces into textures, a few per frame. Failing to decode
+// the sprites at startup quits, on a reload the old texture is kept.
+void uploadAssets(GameState *state) {
+  Assets *assets = &state->assets;
+  const int count = SDL_AtomicGet(&assets->count);
+  uint uploads = 0;
+
+  for (int i = 0; i < count && uploads < ASSET_UPLOADS; i++) {
+    Asset *asset = &assets->assets[i];
+    const int status = SDL_AtomicGet(&asset->status);
+
+    // Decoded from a file that changed since, the new one is wanted
+    if ((status == ASSET_DECODED || status == ASSET_FAILED) &&
+        SDL_AtomicGet(&asset->changed)) {
+      requeueAsset(assets, asset);
+      continue;
+    }
+    if (status == ASSET_FAILED) {
+      printf("Could not load %s! SDL_Error: %s\n", asset->path, asset->error);
+      if (!*asset->texture)
+        quit(state, 1);
+      SDL_AtomicSet(&asset->status, ASSET_READY);
+      continue;
+    }
+    if (status != ASSET_DECODED)
+      continue;
+
+    SDL_Texture *texture =
+      SDL_CreateTextureFromSurface(state->renderer, asset->surface);
+    SDL_Texture *mirrored =
+      asset->mirrored
+        ? SDL_CreateTextureFromSurface(state->renderer, asset->mirroredSurface)
+        : NULL;
+    if (!texture || (asset->mirrored && !mirrored)) {
+      printf("Could not place the sprites! SDL_Error: %s\n", SDL_GetError());
+      quit(state, 1);
+    }
+    if (*asset->texture)
+      SDL_DestroyTexture(*asset->texture);
+    *asset->texture = texture;
+    if (asset->mirrored) {
+      if (*asset->mirrored)
+        SDL_DestroyTexture(*asset->mirrored);
+      *asset->mirrored = mirrored;
+    }
+    SDL_FreeSurface(asset->surface);
+    SDL_FreeSurface(asset->mirroredSurface);
+    asset->surface = asset->mirroredSurface = NULL;
+    SDL_AtomicSet(&asset->status, ASSET_READY);
+    uploads++;
+
+    // The cached layer may have been drawn with the old texture, or without it
+    invalidateStaticLayer(state);
+  }
+}
+
+// Whether every requested asset has a texture, even an outdated one
+bool assetsLoaded(GameState *state) {
+  const int count = SDL_AtomicGet(&state->assets.count);
+  for (int i = 0; i < count; i++) {
+    if (!*state->assets.assets[i].texture)
+      return false;
+  }
+  return true;
+}
+
+// @return How many of the requested assets are loaded, from 0 to 1
+float assetsProgress(GameState *state) {
+  const int count = SDL_AtomicGet(&state->assets.count);
+  int ready = 0;
+  for (int i = 0; i < count; i++)
+    ready += SDL_AtomicGet(&state->assets.assets[i].status) == ASSET_READY;
+  return count ? (float)ready / count : 1;
+}
+
+// Stops the loader and frees what was not uploaded, the textures themselves
+// belong to whoever requested them
+void freeAssets(GameState *state) {
+  Assets *assets = &state->assets;
+
+  SDL_AtomicSet(&assets->quit, 1);
+  if (assets->thread) {
+    SDL_SemPost(assets->wake);
+    SDL_WaitThread(assets->thread, NULL);
+    assets->thread = NULL;
+  }
+  if (assets->wake)
+    SDL_DestroySemaphore(assets->wake);
+  assets->wake = NULL;
+
+  const int count = SDL_AtomicGet(&assets->count);
+  for (int i = 0; i < count; i++) {
+    SDL_FreeSurface(assets->assets[i].surface);
+    SDL_FreeSurface(assets->assets[i].mirroredSurface);
+    assets->assets[i].surface = assets->assets[i].mirroredSurface = NULL;
+    free(assets->assets[i].path);
+    assets->assets[i].path = NULL;
+  }
+  SDL_AtomicSet(&assets->count, 0);
+}
@@ -0,0 +1,17 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "gameState.h"
+
+void initAssets(GameState *state);
+void requestAsset(GameState *state,
+                  const char *path,
+                  SDL_Texture **texture,
+                  SDL_Texture **mirrored);
+bool reloadAsset(GameState *state, const char *path);
+void uploadAssets(GameState *state);
+bool assetsLoaded(GameState *state);
+float assetsProgress(GameState *state);
+void freeAssets(GameState *state);
+
+#endif
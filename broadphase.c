@@ -0,0 +1,222 @@
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+#include "broadphase.h"
+#include "enemy.h"
+#include "gameState.h"
+#include "items.h"
+
+// Every body gets its own id, so its proxy can be found without searching
+static uint bodyId(const BodyKind kind, const ushort index) {
+  switch (kind) {
+    case BODY_PLAYER:
+      return index;
+    case BODY_FIREBALL:
+      return MAX_PLAYERS + index;
+    case BODY_ITEM:
+      return MAX_PLAYERS * (1 + MAX_FIREBALLS) + index;
+    case BODY_ENEMY:
+      return MAX_PLAYERS * (1 + MAX_FIREBALLS) + MAX_BLOCKS + index;
+  }
+  return MAX_PROXIES;
+}
+
+// Moves the proxy of a body to where it sweeps this tick, creating it if the
+// body had none. Bodies not updated before the next sweep are dropped.
+// @param box: Where the body is now
+// @param velocity: How much the body moves this tick
+void updateProxy(Broadphase *bp,
+                 const BodyKind kind,
+                 const ushort index,
+                 const Box *box,
+                 const Velocity velocity) {
+  const uint id = bodyId(kind, index);
+  if (id >= MAX_PROXIES)
+    return;
+
+  if (!bp->slots[id]) {
+    if (bp->count >= MAX_PROXIES)
+      return;
+    bp->proxies[bp->count].kind = kind;
+    bp->proxies[bp->count].index = index;
+    bp->slots[id] = ++bp->count;
+  }
+
+  Proxy *proxy = &bp->proxies[bp->slots[id] - 1];
+  proxy->alive = true;
+  proxy->minX = box->x + (velocity.x < 0 ? velocity.x : 0);
+  proxy->maxX = box->x + box->w + (velocity.x > 0 ? velocity.x : 0);
+  proxy->minY = box->y + (velocity.y < 0 ? velocity.y : 0);
+  proxy->maxY = box->y + box->h + (velocity.y > 0 ? velocity.y : 0);
+}
+
+// Sorts the proxies along X and collects every pair whose bounds overlap.
+// Only the neighbours that start before a proxy ends are ever compared.
+void sweepBroadphase(Broadphase *bp) {
+  uint count = 0;
+
+  // Drop the bodies that were not updated, keeping the order
+  for (uint i = 0; i < bp->count; i++) {
+    Proxy proxy = bp->proxies[i];
+    if (!proxy.alive) {
+      bp->slots[bodyId(proxy.kind, proxy.index)] = 0;
+      continue;
+    }
+    proxy.alive = false;
+    bp->proxies[count++] = proxy;
+  }
+  bp->count = count;
+
+  // Bodies barely move in a tick, so the order from the last sweep is almost
+  // right and the insertion sort has little to do
+  bp->swaps = 0;
+  for (uint i = 1; i < count; i++) {
+    const Proxy proxy = bp->proxies[i];
+    uint j = i;
+    while (j > 0 && bp->proxies[j - 1].minX > proxy.minX) {
+      bp->proxies[j] = bp->proxies[j - 1];
+      j--;
+    }
+    bp->proxies[j] = proxy;
+    bp->swaps += i - j;
+  }
+  for (uint i = 0; i < count; i++)
+    bp->slots[bodyId(bp->proxies[i].kind, bp->proxies[i].index)] = i + 1;
+
+  // Touching edges do not overlap, same as boxIntersects()
+  bp->pairCount = 0;
+  for (uint i = 0; i < count; i++) {
+    const Proxy *a = &bp->proxies[i];
+
+    for (uint j = i + 1; j < count && bp->proxies[j].minX < a->maxX; j++) {
+      const Proxy *b = &bp->proxies[j];
+      if (b->minY >= a->maxY || b->maxY <= a->minY)
+        continue;
+
+      if (bp->pairCount >= MAX_PAIRS)
+        return;
+
+      const bool swap = b->kind < a->kind;
+      bp->pairs[bp->pairCount++] = (BodyPair){
+        .kindA = swap ? b->kind : a->kind,
+        .kindB = swap ? a->kind : b->kind,
+        .a = swap ? b->index : a->index,
+        .b = swap ? a->index : b->index,
+      };
+    }
+  }
+}
+
+// Finds the moving bodies that may touch each other this tick
+void broadphase(GameState *state) {
+  Broadphase *bp = &state->broadphase;
+  const World *world = &state->world;
+
+  for (uint p = 0; p < world->playerCount; p++) {
+    const Player *player = &world->players[p];
+    updateProxy(bp, BODY_PLAYER, p, &player->hitbox, player->velocity);
+
+    // Numbered across the players, like in the contacts
+    for (ushort i = 0; i < MAX_FIREBALLS; i++) {
+      const Fireball *ball = &player->fireballs[i];
+      if (ball->visible)
+        updateProxy(bp,
+                    BODY_FIREBALL,
+                    p * MAX_FIREBALLS + i,
+                    &ball->rect,
+                    ball->velocity);
+    }
+  }
+
+  for (uint i = 0; i < world->blocksLenght; i++) {
+    const Item *item = &world->blocks[i].item;
+    if (item->free && item->visible && itemBehaviors[item->type].powerUp)
+      updateProxy(bp, BODY_ITEM, i, &item->rect, item->velocity);
+  }
+
+  const Enemies *enemies = &world->enemies;
+  for (uint i = 0; i < enemies->count; i++) {
+    if (enemies->lod[i] == ENEMY_ASLEEP)
+      continue;
+
+    const Box box = enemyBox(enemies, i, NUM(state->screen.tile));
+    updateProxy(
+      bp, BODY_ENEMY, i, &box, (Velocity){enemies->vx[i], enemies->vy[i]});
+  }
+
+  sweepBroadphase(bp);
+}
+
+// Moves thousands of boxes around and measures the broadphase against
+// checking every pair
+void benchBroadphase(GameState *state) {
+  static Box boxes[MAX_PROXIES];
+  static Velocity velocities[MAX_PROXIES];
+  const uint sizes[] = {1000, 2000, 4000}, ticks = 600;
+  const double freq = SDL_GetPerformanceFrequency();
+  Broadphase *bp = &state->broadphase;
+
+  srand(1);
+  for (uint s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+    const uint n = sizes[s];
+    // The same density for every size, about two boxes per tile column
+    const Num w = NUM(n * 8), h = NUM(NATIVE_HEIGHT), size = NUM(NATIVE_TILE);
+
+    memset(bp, 0, sizeof(Broadphase));
+    for (uint i = 0; i < n; i++) {
+      boxes[i] = (Box){NUM(rand() % (n * 8 - NATIVE_TILE)),
+                       NUM(rand() % (NATIVE_HEIGHT - NATIVE_TILE)),
+                       size,
+                       size};
+      velocities[i] = (Velocity){NUM(rand() % 5 - 2), NUM(rand() % 5 - 2)};
+    }
+
+    double pairs = 0, swaps = 0;
+    const Uint64 start = SDL_GetPerformanceCounter();
+    for (uint t = 0; t < ticks; t++) {
+      for (uint i = 0; i < n; i++) {
+        Box *box = &boxes[i];
+        Velocity *velocity = &velocities[i];
+        box->x += velocity->x;
+        box->y += velocity->y;
+        if (box->x < 0 || box->x + box->w > w)
+          velocity->x = -velocity->x;
+        if (box->y < 0 || box->y + box->h > h)
+          velocity->y = -velocity->y;
+        // Stand-ins for a crowd of enemies
+        updateProxy(bp, BODY_ENEMY, i, box, *velocity);
+      }
+      sweepBroadphase(bp);
+      pairs += bp->pairCount;
+      swaps += bp->swaps;
+    }
+    const double sweepTime = (SDL_GetPerformanceCounter() - start) / freq;
+
+    // Every pair once, on the last tick, to check nothing was missed
+    uint bruteCount = 0;
+    const Uint64 bruteStart = SDL_GetPerformanceCounter();
+    for (uint i = 0; i < n; i++) {
+      const Proxy *a = &bp->proxies[bp->slots[bodyId(BODY_ENEMY, i)] - 1];
+      for (uint j = i + 1; j < n; j++) {
+        const Proxy *b = &bp->proxies[bp->slots[bodyId(BODY_ENEMY, j)] - 1];
+        if (a->minX < b->maxX && b->minX < a->maxX && a->minY < b->maxY &&
+            b->minY < a->maxY)
+          bruteCount++;
+      }
+    }
+    const double bruteTime = (SDL_GetPerformanceCounter() - bruteStart) / freq;
+
+    printf("Broadphase with %u bodies: %.3f us per tick, %.1f pairs, %.1f "
+           "swaps\n",
+           n,
+           sweepTime * 1e6 / ticks,
+           pairs / ticks,
+           swaps / ticks);
+    printf("Every pair with %u bodies: %.3f us, %u pairs (broadphase %u)\n",
+           n,
+           bruteTime * 1e6,
+           bruteCount,
+           bp->pairCount);
+  }
+  memset(bp, 0, sizeof(Broadphase));
+}
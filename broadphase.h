@@ -0,0 +1,15 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include "gameState.h"
+
+void updateProxy(Broadphase *bp,
+                 const BodyKind kind,
+                 const ushort index,
+                 const Box *box,
+                 const Velocity velocity);
+void sweepBroadphase(Broadphase *bp);
+void broadphase(GameState *state);
+void benchBroadphase(GameState *state);
+
+#endif
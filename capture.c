@@ -0,0 +1,213 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_atomic.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_thread.h>
+#include <string.h>
+#include "capture.h"
+#include "gameState.h"
+#include "utils.h"
+
+// Full resolution chroma, so neighbouring pixels never bleed together
+#define Y4M_HEADER "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n"
+
+static bool isY4m(const char *path) {
+  const size_t length = strlen(path);
+  return length >= 4 && !SDL_strcasecmp(path + length - 4, ".y4m");
+}
+
+// Appends the planes as the next frame of the stream
+static void appendPlanes(Capture *capture) {
+  const int count = capture->w * capture->h;
+
+  if (SDL_RWwrite(capture->stream, "FRAME\n", 6, 1) != 1 ||
+      SDL_RWwrite(capture->stream, capture->planes, count * 3, 1) != 1)
+    printf("Could not write frame %u! SDL_Error: %s\n",
+           capture->written,
+           SDL_GetError());
+  capture->written++;
+}
+
+// Converts to BT.601 studio range YUV and appends it to the stream. The
+// stream has a fixed frame rate, so every dropped frame before this one is
+// filled with the frame before it.
+static void writeY4m(Capture *capture, const Uint32 *pixels, uint number) {
+  const int count = capture->w * capture->h;
+  Uint8 *y = capture->planes, *u = y + count, *v = u + count;
+
+  // The planes still hold the last frame written
+  while (capture->written && capture->written < number)
+    appendPlanes(capture);
+
+  for (int i = 0; i < count; i++) {
+    const int r = pixels[i] >> 16 & 0xFF, g = pixels[i] >> 8 & 0xFF,
+              b = pixels[i] & 0xFF;
+    y[i] = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+    u[i] = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+    v[i] = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+  }
+
+  // Only when the first frames were dropped, this one stands in for them
+  while (capture->written <= number)
+    appendPlanes(capture);
+}
+
+static void writePng(Capture *capture, Uint32 *pixels, uint number) {
+  char file[4096];
+  SDL_snprintf(file, sizeof(file), "%s%05u.png", capture->path, number);
+
+  SDL_Surface *surface =
+    SDL_CreateRGBSurfaceWithFormatFrom(pixels,
+                                       capture->w,
+                                       capture->h,
+                                       32,
+                                       capture->w * 4,
+                                       SDL_PIXELFORMAT_ARGB8888);
+  if (!surface || IMG_SavePNG(surface, file))
+    printf("Could not write %s! SDL_Error: %s\n", file, SDL_GetError());
+  SDL_FreeSurface(surface);
+}
+
+// Writes every captured frame, then sleeps until more arrive
+static int encoder(void *data) {
+  Capture *capture = data;
+
+  while (true) {
+    SDL_SemWait(capture->wake);
+    // Checked first, the frames from before the stop are still written
+    const bool quitting = SDL_AtomicGet(&capture->quit);
+
+    const int head = SDL_AtomicGet(&capture->head);
+    for (int tail = SDL_AtomicGet(&capture->tail); tail != head; tail++) {
+      const uint slot = (uint)tail % CAPTURE_SLOTS;
+      Uint32 *pixels = (Uint32 *)capture->pixels[slot];
+      if (capture->stream)
+        writeY4m(capture, pixels, capture->numbers[slot]);
+      else
+        writePng(capture, pixels, capture->numbers[slot]);
+      // Only handing the slot back once it is written
+      SDL_AtomicSet(&capture->tail, tail + 1);
+    }
+
+    if (quitting)
+      return 0;
+  }
+}
+
+// Captures every presented frame from now on, at the native resolution
+// @param path: A file ending in .y4m for a raw video stream, anything else
+// is the prefix of numbered PNG files
+void startCapture(GameState *state, const char *path) {
+  Capture *capture = &state->capture;
+  // Both draw at the native resolution, so frames read back whole
+  if (!state->target && !state->surface.enabled) {
+    printf("Capturing needs render target support\n");
+    quit(state, 1);
+  }
+
+  capture->w = state->screen.w;
+  capture->h = state->screen.h;
+  capture->path = catpath(state, path, "");
+  SDL_AtomicSet(&capture->head, 0);
+  SDL_AtomicSet(&capture->tail, 0);
+  SDL_AtomicSet(&capture->quit, 0);
+
+  for (uint i = 0; i < CAPTURE_SLOTS; i++) {
+    capture->pixels[i] = malloc(capture->w * capture->h * 4);
+    if (!capture->pixels[i]) {
+      printf("Could not allocate memory for the capture\n");
+      quit(state, 1);
+    }
+  }
+
+  if (isY4m(path)) {
+    capture->planes = malloc(capture->w * capture->h * 3);
+    capture->stream = SDL_RWFromFile(path, "wb");
+    if (!capture->planes || !capture->stream) {
+      printf("Could not open %s! SDL_Error: %s\n", path, SDL_GetError());
+      quit(state, 1);
+    }
+
+    char header[64];
+    const int length = SDL_snprintf(
+      header, sizeof(header), Y4M_HEADER, capture->w, capture->h, TICK_RATE);
+    SDL_RWwrite(capture->stream, header, length, 1);
+  }
+
+  capture->wake = SDL_CreateSemaphore(0);
+  if (capture->wake)
+    capture->thread = SDL_CreateThread(encoder, "encoder", capture);
+  if (!capture->thread) {
+    printf("Could not start the encoder! SDL_Error: %s\n", SDL_GetError());
+    quit(state, 1);
+  }
+}
+
+// Reads the frame back into a free slot for the encoder. Call it while the
+// native resolution target is still bound. When every slot is waiting on
+// the encoder the frame is dropped.
+void captureFrame(GameState *state) {
+  Capture *capture = &state->capture;
+  if (!capture->thread)
+    return;
+
+  const Uint64 start = SDL_GetPerformanceCounter();
+  const uint number = capture->frames + capture->dropped;
+  const int head = SDL_AtomicGet(&capture->head);
+  const uint slot = (uint)head % CAPTURE_SLOTS;
+
+  if ((uint)head - (uint)SDL_AtomicGet(&capture->tail) >= CAPTURE_SLOTS ||
+      SDL_RenderReadPixels(state->renderer,
+                           NULL,
+                           SDL_PIXELFORMAT_ARGB8888,
+                           capture->pixels[slot],
+                           capture->w * 4))
+    capture->dropped++;
+  else {
+    capture->numbers[slot] = number;
+    SDL_AtomicSet(&capture->head, head + 1);
+    SDL_SemPost(capture->wake);
+    capture->frames++;
+  }
+
+  const double elapsed = (SDL_GetPerformanceCounter() - start) * 1e3 /
+                         SDL_GetPerformanceFrequency();
+  capture->total += elapsed;
+  if (elapsed > capture->worst)
+    capture->worst = elapsed;
+}
+
+// Waits for the encoder to write the frames left, then reports the cost
+void stopCapture(GameState *state) {
+  Capture *capture = &state->capture;
+  if (capture->thread) {
+    SDL_AtomicSet(&capture->quit, 1);
+    SDL_SemPost(capture->wake);
+    SDL_WaitThread(capture->thread, NULL);
+    capture->thread = NULL;
+
+    // The frames dropped at the end still take their time in the stream
+    while (capture->stream && capture->written &&
+           capture->written < capture->frames + capture->dropped)
+      appendPlanes(capture);
+
+    const uint attempts = capture->frames + capture->dropped;
+    printf("Captured %u frames to %s, dropped %u\n",
+           capture->frames,
+           capture->path,
+           capture->dropped);
+    if (attempts)
+      printf("Capture overhead per frame: average %.3f ms, worst %.3f ms\n",
+             capture->total / attempts,
+             capture->worst);
+  }
+
+  if (capture->wake)
+    SDL_DestroySemaphore(capture->wake);
+  if (capture->stream)
+    SDL_RWclose(capture->stream);
+  for (uint i = 0; i < CAPTURE_SLOTS; i++)
+    free(capture->pixels[i]);
+  free(capture->planes);
+  free(capture->path);
+  *capture = (Capture){0};
+}
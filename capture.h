@@ -0,0 +1,10 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "gameState.h"
+
+void startCapture(GameState *state, const char *path);
+void captureFrame(GameState *state);
+void stopCapture(GameState *state);
+
+#endif
@@ -0,0 +1,111 @@
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+#include "colliders.h"
+#include "gameState.h"
+
+// A used block back in its place can never be bumped or broken again
+static bool blockSettled(const Block *block) {
+  return !block->broken && block->type == EMPTY && !block->gotHit &&
+         block->rect.y == block->initY;
+}
+
+// Rows first, so boxes on the same row end up next to each other
+static int compareRows(const void *a, const void *b) {
+  const Box *ba = a, *bb = b;
+
+  if (ba->y != bb->y)
+    return ba->y < bb->y ? -1 : 1;
+  if (ba->h != bb->h)
+    return ba->h < bb->h ? -1 : 1;
+  if (ba->x != bb->x)
+    return ba->x < bb->x ? -1 : 1;
+  return 0;
+}
+
+static int compareColumns(const void *a, const void *b) {
+  const Box *ba = a, *bb = b;
+
+  if (ba->x != bb->x)
+    return ba->x < bb->x ? -1 : 1;
+  if (ba->w != bb->w)
+    return ba->w < bb->w ? -1 : 1;
+  if (ba->y != bb->y)
+    return ba->y < bb->y ? -1 : 1;
+  return 0;
+}
+
+// Joins the sorted boxes that continue the one before them
+// @param rows: Whether to join along rows, or else along columns
+// @return How many boxes are left
+static uint joinBoxes(Box boxes[], const uint count, const bool rows) {
+  uint left = 0;
+
+  for (uint i = 0; i < count; i++) {
+    const Box *box = &boxes[i];
+    Box *last = left ? &boxes[left - 1] : NULL;
+
+    if (last && rows && last->y == box->y && last->h == box->h &&
+        last->x + last->w == box->x)
+      last->w += box->w;
+    else if (last && !rows && last->x == box->x && last->w == box->w &&
+             last->y + last->h == box->y)
+      last->h += box->h;
+    else
+      boxes[left++] = *box;
+  }
+  return left;
+}
+
+// Greedy merging, the runs of each row are joined first, then the runs that
+// are stacked with the same span. Tiles on a grid end up as few rectangles.
+// @return How many boxes are left
+static uint mergeBoxes(Box boxes[], const uint count) {
+  qsort(boxes, count, sizeof(Box), compareRows);
+  const uint runs = joinBoxes(boxes, count, true);
+  qsort(boxes, runs, sizeof(Box), compareColumns);
+  return joinBoxes(boxes, runs, false);
+}
+
+// Makes the colliders again when the ground or a settled block changed,
+// which is rare, so this is mostly a comparison. Call this at the start of
+// each tick, the world may have been replaced since the last.
+void updateColliders(GameState *state) {
+  const World *world = &state->world;
+  Colliders *colliders = &state->colliders;
+  const size_t groundSize = sizeof(Box) * world->objsLength,
+               blocksSize = sizeof(Box) * world->blocksLenght;
+  Box blocks[MAX_BLOCKS] = {0};
+
+  for (uint i = 0; i < world->blocksLenght; i++)
+    if (blockSettled(&world->blocks[i]))
+      blocks[i] = world->blocks[i].rect;
+
+  if (world->objsLength == colliders->groundLength &&
+      world->blocksLenght == colliders->blocksLength &&
+      !memcmp(world->objs, colliders->ground, groundSize) &&
+      !memcmp(blocks, colliders->blocks, blocksSize))
+    return;
+
+  colliders->groundLength = world->objsLength;
+  colliders->blocksLength = world->blocksLenght;
+  memcpy(colliders->ground, world->objs, groundSize);
+  memcpy(colliders->blocks, blocks, blocksSize);
+
+  memcpy(colliders->list, world->objs, groundSize);
+  colliders->groundCount = mergeBoxes(colliders->list, world->objsLength);
+
+  uint count = 0;
+  Box *settled = &colliders->list[colliders->groundCount];
+  for (uint i = 0; i < world->blocksLenght; i++) {
+    colliders->merged[i] = !boxEmpty(&blocks[i]);
+    if (colliders->merged[i])
+      settled[count++] = blocks[i];
+  }
+  colliders->count = colliders->groundCount + mergeBoxes(settled, count);
+}
+
+// Blocks still sound like blocks when hit from below
+bool colliderIsBlock(const Colliders *colliders, const uint index) {
+  return index >= colliders->groundCount;
+}
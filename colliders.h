@@ -0,0 +1,9 @@
+#ifndef COLLIDERS_H
+#define COLLIDERS_H
+
+#include "gameState.h"
+
+void updateColliders(GameState *state);
+bool colliderIsBlock(const Colliders *colliders, const uint index);
+
+#endif
@@ -1,23 +1,42 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_rect.h>
 #include <SDL2/SDL_stdinc.h>
+#include <stdlib.h>
+#include "colliders.h"
+#include "collision.h"
+#include "enemy.h"
 #include "gameState.h"
+#include "init.h"
+#include "items.h"
+#include "sound.h"
+#include "timeline.h"
+
+// Points given for each thing the player does
+#define COIN_POINTS 200
+#define ENEMY_POINTS 100
+#define POWERUP_POINTS 1000
+#define BREAK_POINTS 50
 
 // Uses CCD to calculate acurately where and who is colliding
 // @param a: The collider rectangle
 // @param velocity: The collider velocity
 // @param b: The object rectangle
 // @param step: The positive number of steps incremented each iteration
+// @param toi: If not NULL, receives how much of the velocity was travelled
+// before the hit, from 0 to 1
 // @return 0 for no collision, 1 for X collision and -1 for Y collision
-int collision(SDL_FRect a,
+int collision(Box a,
               const Velocity velocity,
-              const SDL_FRect b,
-              const int step) {
-  if (step < 1 || SDL_FRectEmpty(&a) || SDL_FRectEmpty(&b))
+              const Box b,
+              const Num step,
+              Num *toi) {
+  if (step < NUM(1) || boxEmpty(&a) || boxEmpty(&b))
     return 0;
 
   const bool xforward = velocity.x > 0, yforward = velocity.y > 0;
-  const float xgoal = a.x + velocity.x, ygoal = a.y + velocity.y;
+  const Num xgoal = a.x + velocity.x, ygoal = a.y + velocity.y;
+  const Num xstart = a.x, ystart = a.y;
+  const Num length = NUM_ABS(velocity.x) + NUM_ABS(velocity.y);
 
   while (a.x != xgoal) {
     a.x += xforward ? step : -step;
@@ -25,9 +44,11 @@ int collision(SDL_FRect a,
     if ((xforward && a.x > xgoal) || (!xforward && a.x < xgoal))
       a.x = xgoal;
 
-    if (!SDL_HasIntersectionF(&a, &b))
+    if (!boxIntersects(&a, &b))
       continue;
 
+    if (toi)
+      *toi = NUM_DIV(NUM_ABS(a.x - xstart), length);
     return 1;
   }
 
@@ -37,9 +58,11 @@ int collision(SDL_FRect a,
     if ((yforward && a.y > ygoal) || (!yforward && a.y < ygoal))
       a.y = ygoal;
 
-    if (!SDL_HasIntersectionF(&a, &b))
+    if (!boxIntersects(&a, &b))
       continue;
 
+    if (toi)
+      *toi = NUM_DIV(NUM_ABS(a.x - xstart) + NUM_ABS(a.y - ystart), length);
     return -1;
   }
 
@@ -50,10 +73,8 @@ int collision(SDL_FRect a,
 // @param a: The collider rectangle
 // @param b: The object rectangle
 // @param axis: The axis from wich collision was detected
-void resolveCollision(SDL_FRect *const a,
-                      const SDL_FRect *const b,
-                      const int axis) {
-  if (a == NULL || b == NULL || SDL_FRectEmpty(a) || SDL_FRectEmpty(b) || !axis)
+void resolveCollision(Box *const a, const Box *const b, const int axis) {
+  if (a == NULL || b == NULL || boxEmpty(a) || boxEmpty(b) || !axis)
     return;
 
   if (axis > 0) {
@@ -69,257 +90,427 @@ void resolveCollision(SDL_FRect *const a,
   }
 }
 
-// Takes care of the collision of moving items with non-player entities.
-void itemCollision(GameState *state, const ushort index) {
-  if (state == NULL || index < 0)
-    return;
+static bool offScreen(const Box *box, const Num w, const Num h) {
+  return (box->x + box->w < 0 || box->x > w) ||
+         (box->y + box->h < 0 || box->y > h);
+}
 
-  Item *item = &state->blocks[index].item;
-  const ushort isize = state->screen.tile;
+void pushContact(Contact list[],
+                 uint *count,
+                 const uint max,
+                 const Contact contact) {
+  // NOTE: MAX_CONTACTS covers every pair the level can hold, past it the
+  // remaining hits are just missed for this tick
+  if (*count < max)
+    list[(*count)++] = contact;
+}
 
-  if (!item->free || !item->visible || item->type == FIRE_FLOWER)
-    return;
-  if (((item->rect.x + isize < 0 && item->rect.x > state->screen.w) &&
-       (item->rect.y > 0 && item->rect.y + isize < state->screen.h))) {
-    item->visible = false;
-    return;
-  }
+static void addContact(Contacts *contacts,
+                       const BodyKind body,
+                       const ushort bodyIndex,
+                       const TargetKind target,
+                       const ushort targetIndex,
+                       const int axis,
+                       const Num toi) {
+  pushContact(contacts->list,
+              &contacts->count,
+              MAX_CONTACTS,
+              (Contact){
+                .body = body,
+                .target = target,
+                .bodyIndex = bodyIndex,
+                .targetIndex = targetIndex,
+                .axis = axis,
+                .toi = toi,
+              });
+}
 
-  for (uint i = 0; i < state->blocksLenght; i++) {
-    const Block *const block = &state->blocks[i];
-    if (state->blocks[i].broken)
-      continue;
+// First phase of the collision, finds every hit of the moving bodies against
+// the level, and against each other from the pairs of broadphase(). Nothing
+// in the world is changed here, so the result does not depend on the order
+// things are checked.
+void detectContacts(GameState *state) {
+  const World *world = &state->world;
+  const Colliders *colliders = &state->colliders;
+  Contacts *contacts = &state->contacts;
+  const Num tile = NUM(state->screen.tile), w = NUM(state->screen.w),
+            h = NUM(state->screen.h);
+  Num toi = 0;
+  int axis;
+
+  contacts->count = 0;
+
+  // Players, only against what is displayed on screen
+  for (uint p = 0; p < world->playerCount; p++) {
+    const Player *player = &world->players[p];
+
+    for (uint i = 0; i < world->blocksLenght; i++) {
+      const Block *block = &world->blocks[i];
+
+      if (block->broken || colliders->merged[i] ||
+          offScreen(&block->rect, w, h))
+        continue;
 
-    const int result = collision(
-      item->rect, item->velocity, block->rect, state->screen.tile / 2);
+      axis =
+        collision(player->hitbox, player->velocity, block->rect, tile, &toi);
+      if (axis)
+        addContact(contacts, BODY_PLAYER, p, TARGET_BLOCK, i, axis, toi);
+    }
+    for (uint i = 0; i < colliders->count; i++) {
+      const Box *collider = &colliders->list[i];
+      const Num step = colliderIsBlock(colliders, i) ? tile : tile / 2;
 
-    if (!result)
-      continue;
+      if (offScreen(collider, w, h))
+        continue;
 
-    if (block->gotHit && block->rect.y > item->rect.y) {
-      item->velocity.y = -ITEM_JUMP_FORCE;
-      continue;
+      axis = collision(player->hitbox, player->velocity, *collider, step, &toi);
+      if (axis)
+        addContact(contacts, BODY_PLAYER, p, TARGET_COLLIDER, i, axis, toi);
     }
+  }
 
-    // EROR: On the frame before star hopping starts, the resolve is not
-    // properly made FIX: The idiot here just did not account for a start
-    // hitting the top of a block
-    resolveCollision(&item->rect, &block->rect, result);
+  // Bodies against bodies, only for the pairs the broadphase found
+  for (uint i = 0; i < state->broadphase.pairCount; i++) {
+    const BodyPair *pair = &state->broadphase.pairs[i];
 
-    if (result > 0)
-      item->velocity.x = -item->velocity.x;
-    else if (item->type == STAR && item->rect.y + item->rect.h == block->rect.y)
-      item->velocity.y = -ITEM_JUMP_FORCE;
-    else
-      item->velocity.y = 0;
-  }
+    if (pair->kindA == BODY_PLAYER && pair->kindB == BODY_ITEM) {
+      // Like the blocks, items are only picked while their block is on screen
+      const Player *player = &world->players[pair->a];
+      const Block *block = &world->blocks[pair->b];
+      if (offScreen(&block->rect, w, h))
+        continue;
 
-  for (uint i = 0; i < state->objsLength; i++) {
-    const SDL_FRect *const object = &state->objs[i];
-    // ERROR: Using collision() in a if statement causes weird behaviour
-    // ERROR: Using its value in !result or resolveCollision() causes weirder
-    // behaviour const int result = collision(item->rect, item->velocity,
-    // *object, state->screen.tile / 2); NOTE: Temporary trick to stop item
-    // hopping
-    const int result = item->rect.y > object->y - item->rect.h * 1.25 ? -1 : 0;
+      axis = collision(
+        player->hitbox, player->velocity, block->item.rect, tile, &toi);
+      if (axis)
+        addContact(
+          contacts, BODY_PLAYER, pair->a, TARGET_ITEM, pair->b, axis, toi);
+    } else if (pair->kindA == BODY_PLAYER && pair->kindB == BODY_ENEMY) {
+      const Player *player = &world->players[pair->a];
+      const Box box = enemyBox(&world->enemies, pair->b, tile);
+
+      axis = collision(player->hitbox, player->velocity, box, tile, &toi);
+      if (axis)
+        addContact(
+          contacts, BODY_PLAYER, pair->a, TARGET_ENEMY, pair->b, axis, toi);
+    } else if (pair->kindA == BODY_FIREBALL && pair->kindB == BODY_ENEMY) {
+      const Fireball *ball = &world->players[pair->a / MAX_FIREBALLS]
+                                .fireballs[pair->a % MAX_FIREBALLS];
+      const Box box = enemyBox(&world->enemies, pair->b, tile);
+
+      axis = collision(ball->rect, ball->velocity, box, tile / 2, &toi);
+      if (axis)
+        addContact(
+          contacts, BODY_FIREBALL, pair->a, TARGET_ENEMY, pair->b, axis, toi);
+    }
+  }
 
-    if (!result)
+  // Fireballs, MAX_FIREBALLS for each player
+  for (uint i = 0; i < world->playerCount * MAX_FIREBALLS; i++) {
+    const Fireball *ball =
+      &world->players[i / MAX_FIREBALLS].fireballs[i % MAX_FIREBALLS];
+    if (!ball->visible)
       continue;
 
-    resolveCollision(&item->rect, object, result);
+    for (uint j = 0; j < world->blocksLenght; j++) {
+      if (world->blocks[j].broken || colliders->merged[j])
+        continue;
 
-    if (result > 0)
-      item->velocity.x = -item->velocity.x;
-    else if (item->type == STAR && item->rect.y + item->rect.h == object->y)
-      item->velocity.y = -ITEM_JUMP_FORCE;
-    else
-      item->velocity.y = 0;
+      axis = collision(
+        ball->rect, ball->velocity, world->blocks[j].rect, tile / 2, &toi);
+      if (axis)
+        addContact(contacts, BODY_FIREBALL, i, TARGET_BLOCK, j, axis, toi);
+    }
+    for (uint j = 0; j < colliders->count; j++) {
+      axis = collision(
+        ball->rect, ball->velocity, colliders->list[j], tile / 2, &toi);
+      if (axis)
+        addContact(contacts, BODY_FIREBALL, i, TARGET_COLLIDER, j, axis, toi);
+    }
   }
 
-  if (item->rect.x < 0 || item->rect.x + item->rect.w > state->screen.w)
-    item->velocity.x *= -1;
-  else if (item->rect.y + item->rect.w > state->screen.w)
-    item->velocity.y = 0;
-  else if (item->rect.y < 0)
-    item->velocity.y = GRAVITY * 2;
+  detectItemContacts(state);
 }
 
-// Takes care of the collision of the fireballs with non-player entities.
-void fireballCollision(GameState *state, const ushort index) {
-  Fireball *ball = &state->player.fireballs[index];
-  const float fs = state->screen.tile / 2.0;
-
-  if (!ball->visible)
-    return;
-  else if (!((ball->rect.x + fs > 0 && ball->rect.x < state->screen.w) &&
-             (ball->rect.y + fs > 0 && ball->rect.y < state->screen.h))) {
-    ball->visible = false;
-    return;
-  }
-
-  for (uint i = 0; i < state->blocksLenght; i++) {
-    const SDL_FRect *block = &state->blocks[i].rect;
-    (void)block;
+// Contacts are resolved body by body, and for each body from the earliest
+// hit to the latest, ties are broken by the target so the order is total
+static int compareContacts(const void *a, const void *b) {
+  const Contact *ca = a, *cb = b;
+
+  if (ca->body != cb->body)
+    return ca->body - cb->body;
+  if (ca->bodyIndex != cb->bodyIndex)
+    return ca->bodyIndex - cb->bodyIndex;
+  if (ca->toi != cb->toi)
+    return ca->toi < cb->toi ? -1 : 1;
+  if (ca->target != cb->target)
+    return ca->target - cb->target;
+  return ca->targetIndex - cb->targetIndex;
+}
 
-    if (state->blocks[i].broken)
-      continue;
+static void resolvePlayerContact(GameState *state, const Contact *contact) {
+  Player *player = &state->world.players[contact->bodyIndex];
+  const Num tile = NUM(state->screen.tile);
 
-    const int result =
-      collision(ball->rect, ball->velocity, *block, state->screen.tile / 2);
+  if (contact->target == TARGET_COLLIDER) {
+    const Colliders *colliders = &state->colliders;
+    const Box *const object = &colliders->list[contact->targetIndex];
+    const bool block = colliderIsBlock(colliders, contact->targetIndex);
+    const int result = collision(
+      player->hitbox, player->velocity, *object, block ? tile : tile / 2, NULL);
 
     if (!result)
-      continue;
+      return;
+
+    if (result < 0 && player->velocity.y > 0 && object->y > player->hitbox.y)
+      player->onSurface = true;
 
-    resolveCollision(&ball->rect, block, result);
+    resolveCollision(&player->hitbox, object, result);
 
     if (result > 0)
-      ball->velocity.x *= -1;
-    else
-      ball->velocity.y *= -1;
+      player->velocity.x = 0;
+    else {
+      // Settled blocks have nothing left to give
+      if (block && player->velocity.y < 0)
+        playSound(state, SOUND_BUMP);
+      player->velocity.y = 0;
+    }
+    return;
   }
 
-  for (uint i = 0; i < state->objsLength; i++) {
-    const SDL_FRect *const object = &state->objs[i];
+  if (contact->target == TARGET_ENEMY) {
+    Enemies *enemies = &state->world.enemies;
+    const uint index = contact->targetIndex;
+    const Box box = enemyBox(enemies, index, tile);
 
-    const int result =
-      collision(ball->rect, ball->velocity, *object, state->screen.tile / 2);
+    if (enemies->dead[index])
+      return;
 
+    const int result =
+      collision(player->hitbox, player->velocity, box, tile, NULL);
     if (!result)
-      continue;
-
-    resolveCollision(&ball->rect, object, result);
-
-    if (result > 0)
-      ball->velocity.x *= -1;
-    else
-      ball->velocity.y *= -1;
+      return;
+
+    if (player->invincible) {
+      enemies->dead[index] = true;
+      player->score += ENEMY_POINTS;
+      playSound(state, SOUND_STOMP);
+    } else if (result < 0 && player->velocity.y > 0 &&
+               box.y > player->hitbox.y) {
+      // Stomped, the player bounces off it
+      enemies->dead[index] = true;
+      resolveCollision(&player->hitbox, &box, result);
+      player->velocity.y = MAX_JUMP / 2;
+      player->score += ENEMY_POINTS;
+      playSound(state, SOUND_STOMP);
+    } else if (!player->hurt && !player->transforming) {
+      // Walked into it, a big player shrinks and a small one starts over
+      if (player->tall || player->fireForm) {
+        player->tall = false;
+        player->fireForm = false;
+        player->crounching = false;
+        player->hitbox.y += player->hitbox.h - tile;
+        player->hitbox.h = tile;
+        player->rect.y = player->hitbox.y;
+        player->rect.h = tile;
+      } else
+        resetPlayer(state, contact->bodyIndex);
+      // Right away, so the other contacts of this tick pass through
+      player->hurt = true;
+      startSequence(&state->world, SEQUENCE_HURT, contact->bodyIndex, 0);
+    }
+    return;
   }
-}
 
-// Handles the collision a axis per time, call this first with dx only,
-// then call it again for the dy.
-// This function will only run for things that are displayed on screen.
-void playerCollision(GameState *state) {
-  Player *player = &state->player;
-  const ushort tile = state->screen.tile;
-
-  for (uint i = 0; i < state->blocksLenght; i++) {
-    Block *block = &state->blocks[i];
-    Item *item = &block->item;
-
-    // If a block has been broken or is off-screen, skip its collision check
-    if (block->broken ||
-        (block->rect.x + block->rect.w < 0 ||
-         block->rect.x > state->screen.w) ||
-        (block->rect.y + block->rect.h < 0 || block->rect.y > state->screen.h))
-      continue;
+  Block *block = &state->world.blocks[contact->targetIndex];
+  Item *item = &block->item;
 
-    int result = collision(
-      player->hitbox, player->velocity, block->rect, state->screen.tile);
+  // Item collison
+  if (contact->target == TARGET_ITEM) {
+    if (!item->visible ||
+        !collision(player->hitbox, player->velocity, item->rect, tile, NULL))
+      return;
 
-    if (!result && !item->free)
-      continue;
+    item->visible = false;
+    player->score += POWERUP_POINTS;
+    playSound(state, SOUND_POWERUP);
+    if ((item->type == MUSHROOM || item->type == FIRE_FLOWER) &&
+        !player->tall) {
+      player->rect.y -= tile;
+      player->rect.h += tile;
+      player->hitbox.y -= tile;
+      player->hitbox.h = player->rect.h;
+      player->transforming = true;
+      startSequence(
+        &state->world, SEQUENCE_TRANSFORM, contact->bodyIndex, 0);
+    } else if (item->type == FIRE_FLOWER && !player->fireForm)
+      player->fireForm = true;
+    else if (item->type == STAR) {
+      player->invincible = true;
+      startSequence(&state->world, SEQUENCE_STAR, contact->bodyIndex, 0);
+    }
+    return;
+  }
 
-    if (result < 0 && player->velocity.y > 0 &&
-        block->rect.y > player->hitbox.y)
-      player->onSurface = true;
+  if (block->broken)
+    return;
 
-    // ERROR: Player hitbox is resolved uncorrectly when the collider is the
-    // block
-    if (block->rect.y != block->initY &&
-        block->rect.y + block->rect.h > player->hitbox.y + player->velocity.y &&
-        result > 0) {
-      result = -1;
-    }
+  int result =
+    collision(player->hitbox, player->velocity, block->rect, tile, NULL);
+  if (!result)
+    return;
 
-    resolveCollision(&player->hitbox, &block->rect, result);
+  if (result < 0 && player->velocity.y > 0 && block->rect.y > player->hitbox.y)
+    player->onSurface = true;
 
-    // ERROR: When going for the last block a collision bug happens
-    // Block *neighbour = NULL;
-    // if (i + 1 <= state->blocksLenght && player->facingRight) {
-    //   neighbour = &state->blocks[i + 1];
-    //   if (neighbour->rect.x <= player->rect.x + player->rect.w / 2.0)
-    //     continue;
-    // }
+  // ERROR: Player hitbox is resolved uncorrectly when the collider is the
+  // block
+  if (block->rect.y != block->initY &&
+      block->rect.y + block->rect.h > player->hitbox.y + player->velocity.y &&
+      result > 0) {
+    result = -1;
+  }
 
-    if (result > 0)
-      player->velocity.x = 0;
-    else if (result < 0) {
-      if (player->velocity.y < 0) {
-        if (block->type == NOTHING && player->tall)
-          block->broken = true;
-
-        if (!item->free || block->coinCount)
-          block->gotHit = true;
-
-        if (block->type == FULL)
-          item->free = true;
-
-        // TODO: Later add this coin to player->coinCount
-        if (item->type == COINS && block->coinCount) {
-          block->coinCount--;
-          if (!block->coinCount)
-            block->type = EMPTY;
-          for (ushort j = 0; j < block->maxCoins; j++) {
-            Coin *coin = &block->coins[j];
-            if (!coin->onAir) {
-              coin->onAir = true;
-              break;
-            }
+  resolveCollision(&player->hitbox, &block->rect, result);
+
+  if (result > 0)
+    player->velocity.x = 0;
+  else {
+    if (player->velocity.y < 0) {
+      if (block->type == NOTHING && player->tall) {
+        block->broken = true;
+        player->score += BREAK_POINTS;
+        playSound(state, SOUND_BREAK);
+      } else
+        playSound(state, SOUND_BUMP);
+
+      if (!item->free || block->coinCount) {
+        block->gotHit = true;
+        startSequence(&state->world, SEQUENCE_BUMP, contact->targetIndex, 0);
+      }
+
+      if (block->type == FULL)
+        item->free = true;
+
+      if (item->type == COINS && block->coinCount) {
+        block->coinCount--;
+        player->coins++;
+        player->score += COIN_POINTS;
+        playSound(state, SOUND_COIN);
+        if (!block->coinCount)
+          block->type = EMPTY;
+        for (ushort j = 0; j < block->maxCoins; j++) {
+          Coin *coin = &block->coins[j];
+          if (!coin->onAir) {
+            coin->onAir = true;
+            startSequence(
+              &state->world, SEQUENCE_COIN, contact->targetIndex, j);
+            break;
           }
         }
       }
-      player->velocity.y = 0;
     }
+    player->velocity.y = 0;
+  }
+}
 
-    // Item collison
-    if (item->visible && item->free && item->type > COINS) {
-      if (!collision(
-            player->hitbox, player->velocity, item->rect, state->screen.tile))
-        continue;
+static void resolveFireballContact(GameState *state, const Contact *contact) {
+  // The fireballs of each player follow the ones of the last
+  Player *player = &state->world.players[contact->bodyIndex / MAX_FIREBALLS];
+  Fireball *ball = &player->fireballs[contact->bodyIndex % MAX_FIREBALLS];
+  const Num fs = NUM(state->screen.tile) / 2;
+  const Box *target;
 
-      item->visible = false;
-      if ((item->type == MUSHROOM || item->type == FIRE_FLOWER) &&
-          !player->tall) {
-        player->rect.y -= tile;
-        player->rect.h += tile;
-        player->hitbox.h = player->rect.h;
-        player->transforming = true;
-      } else if (item->type == FIRE_FLOWER && !player->fireForm)
-        player->fireForm = true;
-      else if (item->type == STAR)
-        player->invincible = true;
-    }
+  if (contact->target == TARGET_ENEMY) {
+    Enemies *enemies = &state->world.enemies;
+    const Box box =
+      enemyBox(enemies, contact->targetIndex, NUM(state->screen.tile));
+
+    if (!ball->visible || enemies->dead[contact->targetIndex] ||
+        !collision(ball->rect, ball->velocity, box, fs, NULL))
+      return;
+
+    enemies->dead[contact->targetIndex] = true;
+    ball->visible = false;
+    player->score += ENEMY_POINTS;
+    playSound(state, SOUND_STOMP);
+    return;
   }
 
-  // Player with object collision
-  for (uint i = 0; i < state->objsLength; i++) {
-    const SDL_FRect *const object = &state->objs[i];
+  if (contact->target == TARGET_BLOCK) {
+    if (state->world.blocks[contact->targetIndex].broken)
+      return;
+    target = &state->world.blocks[contact->targetIndex].rect;
+  } else
+    target = &state->colliders.list[contact->targetIndex];
 
-    if ((object->x + object->w < 0 || object->x > state->screen.w) ||
-        (object->y + object->h < 0 || object->y > state->screen.h))
-      continue;
+  const int result = collision(ball->rect, ball->velocity, *target, fs, NULL);
+  if (!result)
+    return;
 
-    const int result = collision(
-      player->hitbox, player->velocity, *object, state->screen.tile / 2);
+  resolveCollision(&ball->rect, target, result);
 
-    if (!result)
-      continue;
+  if (result > 0)
+    ball->velocity.x *= -1;
+  else
+    ball->velocity.y *= -1;
+}
 
-    if (result < 0 && player->velocity.y > 0 && object->y > player->hitbox.y)
-      player->onSurface = true;
+// Second phase of the collision, applies the contacts found by
+// detectContacts() in a defined order. Each contact is checked again against
+// where its body is now, since an earlier one may have already moved or
+// stopped it.
+void resolveContacts(GameState *state) {
+  World *world = &state->world;
+  Contacts *contacts = &state->contacts;
+
+  qsort(contacts->list, contacts->count, sizeof(Contact), compareContacts);
+
+  for (uint i = 0; i < contacts->count; i++) {
+    const Contact *contact = &contacts->list[i];
+
+    switch (contact->body) {
+      case BODY_PLAYER:
+        resolvePlayerContact(state, contact);
+        break;
+      case BODY_FIREBALL:
+        resolveFireballContact(state, contact);
+        break;
+      default:
+        // Items are resolved type by type below
+        break;
+    }
+  }
+  resolveItemContacts(state);
 
-    resolveCollision(&player->hitbox, object, result);
+  for (uint i = 0; i < world->playerCount; i++) {
+    Player *player = &world->players[i];
+    if (player->velocity.y)
+      player->onSurface = false;
 
-    if (result > 0)
-      player->velocity.x = 0;
-    else
-      player->velocity.y = 0;
+    if (player->onSurface)
+      player->jumping = false;
   }
 
-  if (player->velocity.y)
-    player->onSurface = false;
+  boundItems(state);
+}
+
+// Takes bodies out of the simulation once they leave the screen
+void cullBodies(GameState *state) {
+  World *world = &state->world;
+  const Num tile = NUM(state->screen.tile), w = NUM(state->screen.w),
+            h = NUM(state->screen.h);
+
+  for (uint i = 0; i < world->playerCount * MAX_FIREBALLS; i++) {
+    Fireball *ball =
+      &world->players[i / MAX_FIREBALLS].fireballs[i % MAX_FIREBALLS];
+    const Num fs = tile / 2;
+
+    if (ball->visible &&
+        !((ball->rect.x + fs > 0 && ball->rect.x < w) &&
+          (ball->rect.y + fs > 0 && ball->rect.y < h)))
+      ball->visible = false;
+  }
 
-  if (player->onSurface)
-    player->jumping = false;
+  cullItems(state);
 }
@@ -4,8 +4,18 @@
 #include <SDL2/SDL.h>
 #include "gameState.h"
 
-void itemCollision(GameState *state, const ushort index);
-void fireballCollision(GameState *state, const ushort index);
-void playerCollision(GameState *state);
+int collision(Box a,
+              const Velocity velocity,
+              const Box b,
+              const Num step,
+              Num *toi);
+void resolveCollision(Box *const a, const Box *const b, const int axis);
+void pushContact(Contact list[],
+                 uint *count,
+                 const uint max,
+                 const Contact contact);
+void cullBodies(GameState *state);
+void detectContacts(GameState *state);
+void resolveContacts(GameState *state);
 
 #endif
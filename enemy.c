@@ -0,0 +1,228 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_timer.h>
+#include "collision.h"
+#include "enemy.h"
+#include "gameState.h"
+#include "jobs.h"
+#include "physics.h"
+
+// Enemies updated per job, enough to outweigh handing the job to a thread
+#define ENEMY_GRAIN 64
+
+// Adds an enemy walking left, asleep until the player gets close
+// @return false when the pool is full
+bool spawnEnemy(World *world, const EnemyType type, const Num x, const Num y) {
+  Enemies *enemies = &world->enemies;
+  if (enemies->count >= MAX_ENEMIES)
+    return false;
+
+  const uint i = enemies->count++;
+  enemies->x[i] = x;
+  enemies->y[i] = y;
+  enemies->vx[i] = -ENEMY_SPEED;
+  enemies->vy[i] = 0;
+  enemies->type[i] = type;
+  enemies->lod[i] = ENEMY_ASLEEP;
+  enemies->dead[i] = false;
+  return true;
+}
+
+// The rectangle of an enemy, koopas are a tile and a half tall
+Box enemyBox(const Enemies *enemies, const uint index, const Num tile) {
+  const Num h = enemies->type[index] == KOOPA ? tile + tile / 2 : tile;
+  return (Box){enemies->x[index], enemies->y[index], tile, h};
+}
+
+// How many ticks an enemy advances on this tick, zero when it does not move.
+// Enemies in reduced range take turns, so only a part of them moves per tick.
+static int enemySteps(const World *world, const uint index) {
+  switch (world->enemies.lod[index]) {
+    case ENEMY_AWAKE:
+      return 1;
+    case ENEMY_REDUCED:
+      return (world->tick + index) % ENEMY_LOD_TICKS ? 0 : ENEMY_LOD_TICKS;
+    default:
+      return 0;
+  }
+}
+
+// Walkers turn around on walls and stop falling on floors
+static void enemyHit(Enemies *enemies,
+                     const uint index,
+                     Box *box,
+                     const Box *target,
+                     const int steps,
+                     const Num tile) {
+  const Velocity velocity = {enemies->vx[index] * steps,
+                             enemies->vy[index] * steps};
+  const int result = collision(*box, velocity, *target, tile / 2, NULL);
+
+  if (!result)
+    return;
+
+  resolveCollision(box, target, result);
+
+  if (result > 0)
+    enemies->vx[index] = -enemies->vx[index];
+  else
+    enemies->vy[index] = 0;
+}
+
+// Moves a range of enemies, in one pass per kind of work. Each enemy only
+// writes to itself, so ranges can run on any thread.
+static void updateEnemyRange(void *data,
+                             const uint chunk,
+                             const uint begin,
+                             const uint end) {
+  GameState *state = data;
+  World *world = &state->world;
+  Enemies *enemies = &world->enemies;
+  const Colliders *colliders = &state->colliders;
+  const Num tile = NUM(state->screen.tile), w = NUM(state->screen.w),
+            h = NUM(state->screen.h);
+  (void)chunk;
+
+  // Level of detail, only from the world, so enemies wake up on the same tick
+  // in a replay or after a rollback. The closest player counts.
+  for (uint i = begin; i < end; i++) {
+    Num distance = NUM_ABS(enemies->x[i] - world->players[0].hitbox.x);
+    for (uint p = 1; p < world->playerCount; p++) {
+      const Num d = NUM_ABS(enemies->x[i] - world->players[p].hitbox.x);
+      if (d < distance)
+        distance = d;
+    }
+    enemies->lod[i] = distance < w       ? ENEMY_AWAKE
+                      : distance < w * 2 ? ENEMY_REDUCED
+                                         : ENEMY_ASLEEP;
+  }
+
+  // Gravity
+  for (uint i = begin; i < end; i++) {
+    const int steps = enemySteps(world, i);
+    if (!steps)
+      continue;
+
+    enemies->vy[i] += GRAVITY * steps;
+    if (enemies->vy[i] > MAX_GRAVITY)
+      enemies->vy[i] = MAX_GRAVITY;
+  }
+
+  // Level collision and movement
+  for (uint i = begin; i < end; i++) {
+    const int steps = enemySteps(world, i);
+    if (!steps)
+      continue;
+
+    Box box = enemyBox(enemies, i, tile);
+    for (uint j = 0; j < world->blocksLenght; j++) {
+      if (!world->blocks[j].broken && !colliders->merged[j])
+        enemyHit(enemies, i, &box, &world->blocks[j].rect, steps, tile);
+    }
+    for (uint j = 0; j < colliders->count; j++)
+      enemyHit(enemies, i, &box, &colliders->list[j], steps, tile);
+
+    enemies->x[i] = box.x + enemies->vx[i] * steps;
+    enemies->y[i] = box.y + enemies->vy[i] * steps;
+  }
+
+  // Falling in a pit
+  for (uint i = begin; i < end; i++) {
+    if (enemies->y[i] > h * 2)
+      enemies->dead[i] = true;
+  }
+}
+
+// Moves the enemies near the player
+void updateEnemies(GameState *state) {
+  parallelFor(&state->jobs,
+              state->world.enemies.count,
+              ENEMY_GRAIN,
+              updateEnemyRange,
+              state);
+}
+
+// Takes the dead enemies out of the pool, keeping the others in order
+void removeDeadEnemies(World *world) {
+  Enemies *enemies = &world->enemies;
+  uint count = 0;
+
+  for (uint i = 0; i < enemies->count; i++) {
+    if (enemies->dead[i])
+      continue;
+
+    enemies->x[count] = enemies->x[i];
+    enemies->y[count] = enemies->y[i];
+    enemies->vx[count] = enemies->vx[i];
+    enemies->vy[count] = enemies->vy[i];
+    enemies->type[count] = enemies->type[i];
+    enemies->lod[count] = enemies->lod[i];
+    enemies->dead[count] = false;
+    count++;
+  }
+  enemies->count = count;
+}
+
+// Walks the player right through a scene
+// @param lods: When not NULL, counts the enemies of each level of detail
+// @return The seconds taken
+static double stressTicks(GameState *state,
+                          const World *scene,
+                          const uint ticks,
+                          uint lods[]) {
+  const double freq = SDL_GetPerformanceFrequency();
+  const Enemies *enemies = &state->world.enemies;
+
+  state->world = *scene;
+  const Uint64 start = SDL_GetPerformanceCounter();
+  for (uint t = 0; t < ticks; t++) {
+    tick(state, INPUT_RIGHT);
+    if (lods == NULL)
+      continue;
+    for (uint i = 0; i < enemies->count; i++)
+      lods[enemies->lod[i]]++;
+  }
+  return (SDL_GetPerformanceCounter() - start) / freq;
+}
+
+// Lays a long floor filled with enemies and prints what each one costs, the
+// player walks right so enemies wake up as it gets close
+void stressEnemies(GameState *state, uint count) {
+  World *world = &state->world;
+  const ushort tile = state->screen.tile;
+  const uint ticks = 600;
+  uint lods[3] = {0, 0, 0};
+
+  if (count > MAX_ENEMIES)
+    count = MAX_ENEMIES;
+
+  // One floor under everything, with two tiles between enemies
+  const Num floorY = NUM(state->screen.h - tile * 2);
+  world->objsLength = 1;
+  world->objs[0] =
+    (Box){0, floorY, NUM(state->screen.w + count * tile * 2), NUM(tile * 2)};
+  world->enemies.count = 0;
+  const World empty = *world;
+
+  for (uint i = 0; i < count; i++) {
+    const EnemyType type = i % 4 ? GOOMBA : KOOPA;
+    const Num h = type == KOOPA ? NUM(tile + tile / 2) : NUM(tile);
+    spawnEnemy(world, type, NUM(state->screen.w + i * tile * 2), floorY - h);
+  }
+  const World scene = *world;
+
+  const double base = stressTicks(state, &empty, ticks, NULL);
+  const double time = stressTicks(state, &scene, ticks, lods);
+  const double total = (lods[0] + lods[1] + lods[2]) / (double)ticks;
+
+  printf("Stress with %u enemies, %u left at the end\n",
+         count,
+         state->world.enemies.count);
+  printf("Tick: %.3f us, %.3f us without enemies\n",
+         time * 1e6 / ticks,
+         base * 1e6 / ticks);
+  printf("Per enemy: %.3f us\n", (time - base) * 1e6 / ticks / total);
+  printf("Average awake %.1f, reduced %.1f, asleep %.1f\n",
+         lods[ENEMY_AWAKE] / (double)ticks,
+         lods[ENEMY_REDUCED] / (double)ticks,
+         lods[ENEMY_ASLEEP] / (double)ticks);
+}
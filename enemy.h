@@ -0,0 +1,12 @@
+#ifndef ENEMY_H
+#define ENEMY_H
+
+#include "gameState.h"
+
+bool spawnEnemy(World *world, const EnemyType type, const Num x, const Num y);
+Box enemyBox(const Enemies *enemies, const uint index, const Num tile);
+void updateEnemies(GameState *state);
+void removeDeadEnemies(World *world);
+void stressEnemies(GameState *state, uint count);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_rect.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+// The number type of positions and velocities in the simulation.
+// Build with FIXED_POINT defined to make it a 16.16 fixed-point integer,
+// which gives bit identical results across compilers and CPUs.
+#ifdef FIXED_POINT
+typedef Sint32 Num;
+
+#define FIXED_SHIFT 16
+#define NUM(x) ((Num)((x) * (1 << FIXED_SHIFT)))
+#define NUM_MUL(a, b) ((Num)(((Sint64)(a) * (b)) >> FIXED_SHIFT))
+#define NUM_DIV(a, b) ((Num)(((Sint64)(a) << FIXED_SHIFT) / (b)))
+#define NUM_ABS(a) abs(a)
+#define NUM_TO_FLOAT(a) ((float)(a) / (1 << FIXED_SHIFT))
+#define NUM_TO_INT(a) ((a) >> FIXED_SHIFT)
+#else
+typedef float Num;
+
+#define NUM(x) ((Num)(x))
+#define NUM_MUL(a, b) ((a) * (b))
+#define NUM_DIV(a, b) ((a) / (b))
+#define NUM_ABS(a) fabsf(a)
+#define NUM_TO_FLOAT(a) (a)
+#define NUM_TO_INT(a) ((int)(a))
+#endif
+
+// A rectangle in simulation space, SDL_FRect is only used for drawing
+typedef struct {
+  Num x, y, w, h;
+} Box;
+
+static inline SDL_FRect boxToFRect(const Box box) {
+  return (SDL_FRect) {NUM_TO_FLOAT(box.x),
+                      NUM_TO_FLOAT(box.y),
+                      NUM_TO_FLOAT(box.w),
+                      NUM_TO_FLOAT(box.h)};
+}
+
+static inline bool boxEmpty(const Box *box) {
+  return box->w <= 0 || box->h <= 0;
+}
+
+// Same rules as SDL_HasIntersectionF, touching edges do not intersect
+static inline bool boxIntersects(const Box *a, const Box *b) {
+  if (boxEmpty(a) || boxEmpty(b))
+    return false;
+  return a->x < b->x + b->w && b->x < a->x + a->w && a->y < b->y + b->h &&
+         b->y < a->y + a->h;
+}
+
+#endif
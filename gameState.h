@@ -4,27 +4,65 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_rect.h>
 #include <stdbool.h>
+#include <time.h>
+#include "fixed.h"
 
-// NOTE: All of these are resolution related
-// TODO: Make these macros global variables initialized
-// in init.c when resolution change is implemented
-#define GRAVITY 0.8f
-#define MAX_GRAVITY 20
-#define SPEED 0.2f
-#define MAX_SPEED 7
-#define JUMP_FORCE 2.5f
-#define MAX_JUMP -15
-#define ITEM_SPEED (SPEED * 12)
-#define ITEM_JUMP_FORCE (JUMP_FORCE * 6)
-#define FRIC 0.85f
+// NOTE: All of these are resolution related, initPhysics() in init.c
+// scales them to the tile size from their values at 64 pixel tiles
+extern Num GRAVITY, MAX_GRAVITY, SPEED, MAX_SPEED, JUMP_FORCE, MAX_JUMP,
+  ITEM_SPEED, ITEM_JUMP_FORCE, BLOCK_SPEED, ENEMY_SPEED;
+#define FRIC NUM(0.85f)
+
+// The internal resolution, upscaled by an integer factor to the window
+#define NATIVE_WIDTH 256
+#define NATIVE_HEIGHT 240
+#define NATIVE_TILE 16
+#define WINDOW_SCALE 3
+
+#define SPRITES_PATH "./assets/sprites/"
+#define DEFAULT_LEVEL "./assets/levels/1-1.txt"
+
+// The simulation always advances in steps of 1 / TICK_RATE seconds
+#define TICK_RATE 60
+#define XFORM_TICKS (2 * TICK_RATE)
+#define STAR_TICKS (20 * TICK_RATE)
+#define FIRING_TICKS (TICK_RATE / 5)
+#define HURT_TICKS (2 * TICK_RATE)
 
 // The maximum ammount of pieces a block can break into
 #define MAX_BLOCK_PARTICLES 4
+// The most coins a single block can hold
+#define MAX_BLOCK_COINS 10
 #define MAX_FIREBALLS 3
+#define MAX_BLOCKS 20
+#define MAX_OBJS 256
+#define MAX_ENEMIES 512
 
 typedef unsigned short ushort;
 
-typedef enum { COINS, MUSHROOM, FIRE_FLOWER, STAR } ItemType;
+// Every type of item and how it behaves, the item kernels are generated
+// from this. X(type, name, powerUp, moves, hops, frames, period, firstFrame)
+// powerUp: Rises out of its block and can be picked up
+// moves: Walks and falls once out, instead of staying on its block
+// hops: Bounces off the floor
+// frames, period, firstFrame: Its animation, period is in milliseconds
+#define ITEM_BEHAVIORS(X)                                                      \
+  X(COINS, Coins, false, false, false, 4, 100, 10)                             \
+  X(MUSHROOM, Mushroom, true, true, false, 1, 180, 0)                          \
+  X(FIRE_FLOWER, FireFlower, true, false, false, 4, 180, 2)                    \
+  X(STAR, Star, true, true, true, 4, 180, 6)
+
+typedef enum {
+#define X(type, ...) type,
+  ITEM_BEHAVIORS(X)
+#undef X
+  ITEM_TYPES
+} ItemType;
+
+typedef struct {
+  bool powerUp, moves, hops;
+  ushort frames, period, firstFrame;
+} ItemBehavior;
 typedef enum { NOTHING, FULL, EMPTY } BlockState;
 // TODO: Nest this inside of Block if possible
 typedef enum {
@@ -58,77 +96,718 @@ typedef enum {
 } PlayerFrame;
 
 typedef struct {
-  float x, y;
+  Num x, y;
 } Velocity;
 
 typedef struct {
-  SDL_FRect rect;
+  Box rect;
   Velocity velocity;
   bool visible;
 } Fireball;
 
 typedef struct {
-  SDL_FRect rect, hitbox;
+  Box rect, hitbox;
   Velocity velocity;
   // TODO: Remove a lot of these
   bool tall, fireForm, invincible, transforming, onSurface, jumping,
     facingRight, walking, crounching, firing;
+  // Enemies pass through it for a while after they hurt it
+  bool hurt;
   PlayerFrame frame;
   Fireball fireballs[MAX_FIREBALLS];
+  ushort coins;
+  uint score;
 } Player;
 
+// The second player only ever joins over the network
+#define MAX_PLAYERS 2
+
 typedef struct {
-  SDL_FRect rect;
+  Box rect;
   Velocity velocity;
   bool free, visible, canJump;
   ItemType type;
 } Item;
 
 typedef struct {
-  SDL_FRect rect;
+  Box rect;
   bool onAir, willFall;
 } Coin;
 
 typedef struct {
-  SDL_FRect rect;
+  Box rect;
   struct Particle {
-    SDL_FRect rect;
+    Box rect;
     Velocity velocity;
   } particles[MAX_BLOCK_PARTICLES];
   // TODO: Remove this
-  float initY;
+  Num initY;
   bool gotHit, broken;
   BlockState type;
   BlockSprite sprite;
   Item item;
   // Maybe implement a linked list instead of a array
-  Coin coins[10];
+  Coin coins[MAX_BLOCK_COINS];
   // TODO: Merge these two
   ushort maxCoins, coinCount;
 } Block;
 
 typedef struct {
   SDL_Texture *mario, *objs, *items, *effects;
+  // Mirrored copy, so facing left is a plain copy instead of a flip
+  SDL_Texture *marioMirrored;
   SDL_Rect srcmario[85], srcsobjs[4], srcitems[20], srceffects[20];
 } Sheets;
 
 typedef struct {
-  uint w, h, xformTimer, starTimer, firingTimer;
+  uint w, h;
   ushort tile, targetFps;
   float deltaTime;
 } Screen;
 
+// Sky and terrain drawn once into a screen sized render target
+typedef struct {
+  SDL_Texture *texture;
+  // Whether the texture holds the current terrain
+  bool held;
+  bool supported;
+} StaticLayer;
+
+// Pixels of a glyph cell in the atlas and on screen
+#define GLYPH_SIZE 8
+#define MAX_HUD_GLYPHS 64
+
+typedef enum {
+  HUD_SCORE,
+  HUD_COINS,
+  HUD_TIME,
+  HUD_FPS,
+  HUD_FRAME_TIME,
+  HUD_TPS,
+  HUD_PING,
+  HUD_NET_RATE,
+  HUD_FIELDS
+} HudField;
+
+// Quads of glyphs drawn together in a single call
+typedef struct {
+  SDL_Vertex vertices[MAX_HUD_GLYPHS * 4];
+  uint count;
+} GlyphRun;
+
+// The labels never change after they are built, the numbers of the fields
+// only have their glyphs swapped when their value changes
+typedef struct {
+  SDL_Texture *atlas;
+  GlyphRun labels, fields;
+  int indices[MAX_HUD_GLYPHS * 6];
+  struct HudSlot {
+    uint first, digits, decimals;
+    bool zeros;
+    int value;
+  } slots[HUD_FIELDS];
+  // Smoothed, in seconds
+  float frameTime;
+} Hud;
+
+// Buttons held during a tick, the simulation only reads input from here
+typedef enum {
+  INPUT_LEFT = 1 << 0,
+  INPUT_RIGHT = 1 << 1,
+  INPUT_DOWN = 1 << 2,
+  INPUT_UP = 1 << 3,
+  // Any of the jump keys, used for the variable jump height
+  INPUT_JUMP = 1 << 4,
+  INPUT_FIRE = 1 << 5
+} InputButton;
+
+typedef Uint8 Input;
+
+typedef enum { GOOMBA, KOOPA } EnemyType;
+
+// How often an enemy is updated, from how far it is from the player
+typedef enum { ENEMY_ASLEEP, ENEMY_REDUCED, ENEMY_AWAKE } EnemyLod;
+
+// Enemies that are not awake but still in range move every ENEMY_LOD_TICKS
+#define ENEMY_LOD_TICKS 4
+
+// Stored as one array per field, so each update pass only touches what it
+// needs. Living enemies are always the first count entries.
+typedef struct {
+  Num x[MAX_ENEMIES], y[MAX_ENEMIES];
+  Num vx[MAX_ENEMIES], vy[MAX_ENEMIES];
+  Uint8 type[MAX_ENEMIES], lod[MAX_ENEMIES];
+  bool dead[MAX_ENEMIES];
+  uint count;
+} Enemies;
+
+typedef enum {
+  SEQUENCE_NONE,
+  SEQUENCE_TRANSFORM,
+  SEQUENCE_STAR,
+  SEQUENCE_FIRING,
+  SEQUENCE_BUMP,
+  SEQUENCE_COIN,
+  SEQUENCE_HURT,
+  SEQUENCE_TYPES
+} SequenceType;
+
+// A bump and ten coins for every block, and four states for each player
+#define MAX_SEQUENCES (MAX_BLOCKS * 11 + 4 * MAX_PLAYERS)
+
+// A scripted animation that advances once per tick, see timeline.h
+typedef struct {
+  Uint8 type;
+  // What it animates, like a block and one of its coins
+  ushort target, index;
+  // The step it resumes at, and the ticks to wait before that
+  ushort step, wait;
+  // Ticks since it started
+  uint ticks;
+} Sequence;
+
+// Everything the simulation reads and writes. It must never hold pointers,
+// so it can be snapshotted and restored with a flat copy.
 typedef struct {
-  SDL_Window *window;
-  SDL_Renderer *renderer;
   // When reading levels, make it a dynamic array
-  Block blocks[20];
-  SDL_FRect objs[20];
+  Block blocks[MAX_BLOCKS];
+  Box objs[MAX_OBJS];
   // When making multiple Levels, move this to Level
   uint objsLength, blocksLenght;
+  Player players[MAX_PLAYERS];
+  uint playerCount;
+  Enemies enemies;
+  Sequence sequences[MAX_SEQUENCES];
+  uint tick;
+  // The input of each player on the last tick
+  Input lastInput[MAX_PLAYERS];
+  bool holdingJump[MAX_PLAYERS];
+} World;
+
+// Two seconds of ticks at 60 fps
+#define SNAPSHOT_COUNT 120
+
+typedef struct {
+  // Ring of the last SNAPSHOT_COUNT worlds, the newest is the current one
+  World *frames;
+  uint head, count;
+  World saved;
+  bool hasSaved, rewinding;
+} Snapshots;
+
+// Keyframes are written every HISTORY_INTERVAL entries, deltas in between
+#define HISTORY_INTERVAL 600
+
+typedef struct {
+  SDL_RWops *file;
+  // The last world written, deltas are made against it
+  World previous;
+  Uint8 *buffer;
+  uint count;
+  Uint64 bytes;
+} HistoryWriter;
+
+typedef struct {
+  SDL_RWops *file;
+  struct HistoryKey {
+    uint index;
+    Sint64 offset;
+  } *keys;
+  uint keyCount, count;
+  // The last decoded entry, so seeking forward does not start over
+  World current;
+  uint currentIndex;
+  Sint64 nextOffset;
+  bool decoded;
+  Uint8 *buffer;
+} HistoryReader;
+
+// Input of every tick, enough to replay a run from the start
+typedef struct {
+  SDL_RWops *file;
+  uint count;
+} Replay;
+
+#define LATENCY_BUCKETS 32
+#define LATENCY_BUCKET_MS 2
+
+// Input to present latency, all times are performance counter values
+typedef struct {
+  Input sampled;
+  // The oldest input change not simulated yet, and not presented yet
+  Uint64 changed, simulated;
+  // The last bucket counts everything past the others
+  uint histogram[LATENCY_BUCKETS + 1];
+  uint samples;
+  double total, worst;
+  // Late sampling waits for the last moment to read input before a present
+  bool late;
+  Uint64 frameStart, lastPresent;
+  // Moving averages, in seconds
+  double framePeriod, renderCost;
+} Latency;
+
+typedef enum { BODY_PLAYER, BODY_FIREBALL, BODY_ITEM, BODY_ENEMY } BodyKind;
+typedef enum {
+  TARGET_BLOCK,
+  TARGET_ITEM,
+  TARGET_OBJECT,
+  TARGET_ENEMY,
+  TARGET_COLLIDER
+} TargetKind;
+
+// Enough for every moving body touching every block and object at once
+#define MAX_CONTACTS 4096
+
+// A hit found by the detection phase, it only holds indices so nothing in the
+// world changes until the contacts are resolved
+typedef struct {
+  Uint8 body, target;
+  ushort bodyIndex, targetIndex;
+  // 1 for X collision and -1 for Y collision
+  Sint8 axis;
+  // How much of the body velocity was travelled before the hit, from 0 to 1
+  Num toi;
+} Contact;
+
+// Detection jobs each fill their own chunk, merged in chunk order afterwards
+#define CONTACT_CHUNKS 8
+#define CHUNK_CONTACTS (MAX_CONTACTS / CONTACT_CHUNKS)
+
+typedef struct {
+  Contact list[MAX_CONTACTS];
+  uint count;
+  struct ContactChunk {
+    Contact list[CHUNK_CONTACTS];
+    uint count;
+  } chunks[CONTACT_CHUNKS];
+} Contacts;
+
+// The blocks whose item is moving this tick, in one dense list per type so
+// every kernel runs over items of a single type. Rebuilt from the world at
+// the start of each tick.
+typedef struct {
+  ushort blocks[ITEM_TYPES][MAX_BLOCKS];
+  uint count[ITEM_TYPES];
+  // The run of sorted contacts of each block's item
+  uint firstContact[MAX_BLOCKS], contactCount[MAX_BLOCKS];
+} ItemLists;
+
+#define MAX_COLLIDERS (MAX_OBJS + MAX_BLOCKS)
+
+// The static tiles of the level merged into as few rectangles as possible,
+// so bodies test fewer of them and slide over the seams between tiles. The
+// ground comes first, then the blocks that can no longer be bumped or broken.
+// The other blocks keep their own rectangle. Items still go by the tiles.
+typedef struct {
+  Box list[MAX_COLLIDERS];
+  uint count, groundCount;
+  // Whether each block is inside one of the colliders
+  bool merged[MAX_BLOCKS];
+  // What the colliders were made from, they are made again once it changes
+  Box ground[MAX_OBJS], blocks[MAX_BLOCKS];
+  uint groundLength, blocksLength;
+} Colliders;
+
+// Bodies are told apart by a single id, the players first, then the
+// fireballs, the items and the enemies
+#define MAX_PROXIES 4096
+#define MAX_PAIRS 8192
+
+// The bounds a body sweeps through during a tick
+typedef struct {
+  Uint8 kind;
+  // Whether the body was updated since the last sweep
+  bool alive;
+  ushort index;
+  Num minX, maxX, minY, maxY;
+} Proxy;
+
+// Two bodies whose swept bounds overlap, the lower kind always comes first
+typedef struct {
+  Uint8 kindA, kindB;
+  ushort a, b;
+} BodyPair;
+
+typedef struct {
+  // Kept sorted by minX between ticks, so sorting again is almost free
+  Proxy proxies[MAX_PROXIES];
+  uint count;
+  // Where the proxy of each body id is, plus one, zero when it has none
+  ushort slots[MAX_PROXIES];
+  BodyPair pairs[MAX_PAIRS];
+  uint pairCount;
+  // Moves made by the last insertion sort
+  uint swaps;
+} Broadphase;
+
+#define MAX_THREADS 8
+// Jobs each thread can have queued at once
+#define JOB_QUEUE_SIZE 256
+
+// Runs the entities from begin to end, chunk tells which part of the range
+// this is so results can be kept apart and merged in order
+typedef void (*JobFunc)(void *data,
+                        const uint chunk,
+                        const uint begin,
+                        const uint end);
+
+typedef struct {
+  JobFunc func;
+  void *data;
+  uint chunk, begin, end;
+} Job;
+
+// The owner thread pushes and pops at the bottom, others steal from the top
+typedef struct {
+  Job jobs[JOB_QUEUE_SIZE];
+  uint top, bottom;
+  SDL_SpinLock lock;
+} JobQueue;
+
+typedef struct Jobs {
+  SDL_Thread *threads[MAX_THREADS];
+  JobQueue queues[MAX_THREADS];
+  struct JobWorker {
+    struct Jobs *jobs;
+    uint index;
+  } workers[MAX_THREADS];
+  // Threads working, counting the main one. With one everything runs inline
+  uint count;
+  SDL_sem *wake;
+  SDL_atomic_t pending, quit;
+} Jobs;
+
+#define MAX_ASSETS 32
+// Textures made per frame, so a burst of decoded assets does not stall one
+#define ASSET_UPLOADS 1
+
+typedef enum {
+  ASSET_QUEUED,
+  ASSET_DECODED,
+  ASSET_FAILED,
+  ASSET_READY
+} AssetStatus;
+
+typedef struct {
+  char *path;
+  // Where the texture goes once it is uploaded
+  SDL_Texture **texture;
+  // Where a horizontally mirrored copy goes, NULL when none is needed
+  SDL_Texture **mirrored;
+  SDL_Surface *surface, *mirroredSurface;
+  char error[128];
+  SDL_atomic_t status;
+  // Set when the file changes again while it is queued, what gets decoded
+  // may be the old file then
+  SDL_atomic_t changed;
+} Asset;
+
+// PNGs are decoded into surfaces on a thread, only the texture upload
+// happens on the render thread
+typedef struct {
+  Asset assets[MAX_ASSETS];
+  // Requested assets, the loader thread decodes up to here
+  SDL_atomic_t count;
+  SDL_Thread *thread;
+  SDL_sem *wake;
+  SDL_atomic_t quit;
+} Assets;
+
+// Watches the sprites and the level file, reloading them when they change
+typedef struct {
+  int fd, sprites, level;
+} Watcher;
+
+typedef enum {
+  SOUND_COIN,
+  SOUND_BUMP,
+  SOUND_BREAK,
+  SOUND_POWERUP,
+  SOUND_FIREBALL,
+  SOUND_STOMP,
+  SOUND_JUMP,
+  SOUND_COUNT
+} SoundId;
+
+#define SAMPLE_RATE 44100
+// A power of two, so the indices can wrap around freely
+#define SOUND_QUEUE_SIZE 64
+// Sounds mixed at once, a new one replaces the oldest when all are playing
+#define MAX_VOICES 8
+
+typedef struct {
+  Sint16 *samples;
+  uint length;
+} Sample;
+
+typedef struct {
+  bool playing;
+  Uint8 sound;
+  uint position;
+} Voice;
+
+// The simulation pushes to the queue and only the audio callback pops, so
+// neither side ever waits for the other
+typedef struct {
+  SDL_AudioDeviceID device;
+  Sample samples[SOUND_COUNT];
+  Uint8 queue[SOUND_QUEUE_SIZE];
+  // Written by the simulation and the callback respectively
+  SDL_atomic_t head, tail;
+  // Only touched by the callback
+  Voice voices[MAX_VOICES];
+  uint dropped;
+} Sound;
+
+#define LEVEL_ARENA_SIZE (256 * 1024)
+#define SCRATCH_ARENA_SIZE (64 * 1024)
+// Ticks played before heap allocations in a frame are counted
+#define MEMORY_WARMUP_TICKS 60
+
+// Bump allocator, everything in it is freed at once by a reset
+typedef struct {
+  Uint8 *base;
+  size_t size, used, peak;
+} Arena;
+
+typedef struct {
+  // Lives until the next level is loaded
+  Arena level;
+  // Lives until the next frame
+  Arena scratch;
+  // Heap allocations counted when the last frame started
+  uint allocations;
+  uint frames, allocatingFrames, worstFrame;
+  // Quit on the first frame past the warm up that allocates
+  bool strict;
+} Memory;
+
+// What a piece of per frame work costs the player when it is skipped
+typedef enum {
+  // Input, ticks, and drawing the world, never skipped
+  WORK_CRITICAL,
+  // Needed soon but fine a few frames late, like texture uploads
+  WORK_DEFERRABLE,
+  // Only looks, where the last results stay up, like the HUD readouts and
+  // where debris and coin arcs are drawn
+  WORK_COSMETIC,
+  WORK_CLASSES
+} WorkClass;
+
+// Frames a class can be skipped in a row before it runs anyway
+#define MAX_DEFERRED_FRAMES 4
+
+// Skips non critical work once the frame has spent part of its budget
+typedef struct {
+  // Performance counter values
+  Uint64 frameStart, budget;
+  uint frame, degraded;
+  // The last frame each class ran on, and whether it runs this one
+  uint lastRun[WORK_CLASSES], decided[WORK_CLASSES];
+  bool allowed[WORK_CLASSES];
+  uint deferred[WORK_CLASSES];
+  bool degradedFrame;
+} Scheduler;
+
+// Every piece of debris and every coin of every block
+#define MAX_EFFECTS (MAX_BLOCKS * (MAX_BLOCK_PARTICLES + MAX_BLOCK_COINS))
+
+// Debris and coin arcs as they were last gathered from the blocks. Frames
+// that skip cosmetic work draw these again instead of walking every block.
+typedef struct {
+  struct Effect {
+    SDL_FRect dst;
+    // A frame of the effects sheet for debris, of the items sheet for coins
+    ushort frame;
+    bool debris;
+  } list[MAX_EFFECTS];
+  uint count;
+} Effects;
+
+// Frames waiting for the encoder, more are dropped instead of waited for
+#define CAPTURE_SLOTS 4
+
+// Copies of the native resolution frame, written out by an encoder thread
+typedef struct {
+  // A .y4m stream, or the prefix of a numbered PNG sequence
+  char *path;
+  SDL_RWops *stream;
+  int w, h;
+  Uint8 *pixels[CAPTURE_SLOTS];
+  uint numbers[CAPTURE_SLOTS];
+  // The Y, U and V planes of the frame being encoded
+  Uint8 *planes;
+  // Frames in the stream so far, dropped ones included, for the encoder
+  uint written;
+  // Written by the render thread and the encoder respectively
+  SDL_atomic_t head, tail;
+  SDL_Thread *thread;
+  SDL_sem *wake;
+  SDL_atomic_t quit;
+  uint frames, dropped;
+  // Time the render thread spent on captures, in milliseconds
+  double total, worst;
+} Capture;
+
+// Sprites compared between frames, past this the whole frame is redrawn
+#define MAX_SURFACE_SPRITES 1024
+// Regions redrawn per frame, past this the closest ones get merged
+#define MAX_DIRTY_RECTS 16
+
+// Where a sprite was drawn and a key of what it looked like
+typedef struct {
+  SDL_Rect bounds;
+  Uint64 key;
+} TracedSprite;
+
+// Renders in software into the window surface, redrawing and presenting
+// only the regions where a sprite moved or changed since the last frame
+typedef struct {
+  bool enabled;
+  // The native resolution frame, it always holds the whole last frame
+  SDL_Surface *frame;
+  // The sprites of the last frame and of this one
+  TracedSprite sprites[2][MAX_SURFACE_SPRITES];
+  uint spriteCount[2], current;
+  bool tracing;
+  // Redraw and present everything on the next frame
+  bool full;
+  // Fill the whole window, borders included, on the next present. Only
+  // presentSurface() clears it, the trace is done with full by then.
+  bool repaint;
+  SDL_Rect dirty[MAX_DIRTY_RECTS];
+  uint dirtyCount;
+  // Size of the window surface last presented to
+  int windowW, windowH;
+  // Window pixels presented
+  Uint64 pixels;
+  uint frames, lastPixels, peakPixels, idleFrames;
+} SurfaceBackend;
+
+// Multiplier Tab fast forwards by when none was given
+#define DEFAULT_FAST_FORWARD 4
+#define MAX_FAST_FORWARD 64
+
+// Runs several ticks per presented frame, the frames stay paced by vsync
+typedef struct {
+  // Multiplier of the tick rate, 0 runs as many ticks as fit in a frame
+  uint multiplier;
+  bool fastForward;
+  // Ticks counted since the measurement started, measured once a second
+  uint ticks, ticksPerSecond, peakTicksPerSecond;
+  Uint32 start, measureStart;
+  Uint64 totalTicks;
+} Speed;
+
+typedef enum {
+  MODE_ACTIVE,
+  MODE_BACKGROUND,
+  MODE_MINIMIZED,
+  POWER_MODES
+} PowerMode;
+
+// The simulation is suspended while the window is minimized or unfocused,
+// the loop then sleeps until something happens instead of spinning
+typedef struct {
+  bool focused, minimized, exposed;
+  // Only the game itself is measured, not the replays and benchmarks
+  bool measuring;
+  PowerMode mode;
+  // Wall and CPU time spent in each mode, CPU time is of every thread
+  Uint32 modeStart;
+  clock_t cpuStart;
+  Uint64 wallTime[POWER_MODES];
+  clock_t cpuTime[POWER_MODES];
+  uint wakeups[POWER_MODES];
+} Idle;
+
+// Ticks of input kept for each player, far more than the delay needs
+#define NET_INPUTS 256
+#define DEFAULT_INPUT_DELAY 3
+#define MAX_INPUT_DELAY 30
+// Bytes before the inputs of a packet, and the most inputs it carries
+#define NET_HEADER 25
+#define NET_PACKET_INPUTS 32
+#define NET_PACKET_SIZE (NET_HEADER + NET_PACKET_INPUTS)
+// Outgoing packets held back at once when simulating jitter
+#define NET_QUEUE 64
+// World hashes kept to compare with the other side, one every second
+#define NET_CHECKS 8
+
+// Two instances playing in lockstep over UDP, see net.c. A tick only runs
+// once the input of both players for it is in.
+typedef struct {
+  bool enabled, host, connected, desynced;
+  int socket;
+  // Where the other side is, in network byte order
+  Uint32 peerAddress;
+  Uint16 peerPort;
+  // The player this side controls, the host is the first
+  uint local;
+  // Ticks between sampling the local input and simulating it
+  uint delay;
+  // The input of each player by tick, every tick before known is in
+  Input inputs[MAX_PLAYERS][NET_INPUTS];
+  uint known[MAX_PLAYERS];
+  // Ticks of local input the other side has
+  uint acked;
+  // Time stamp of the last packet in, echoed back to measure the round trip
+  Uint16 echo;
+  Uint32 echoReceived, lastReceived;
+  // Simulated conditions, loss in percent and jitter in milliseconds
+  uint loss, jitter;
+  Uint32 seed;
+  struct NetPacket {
+    Uint32 due;
+    uint size;
+    Uint8 data[NET_PACKET_SIZE];
+  } queue[NET_QUEUE];
+  uint queued;
+  struct NetCheck {
+    Uint32 tick, hash;
+  } checks[NET_CHECKS];
+  // Smoothed, in milliseconds
+  float rtt, rttJitter;
+  uint sent, received, dropped, stalls;
+  // Bytes in and out since the measurement started, measured once a second
+  uint bytes, bytesPerSecond;
+  Uint64 totalBytes;
+  Uint32 start, measureStart;
+} Net;
+
+typedef struct {
+  SDL_Window *window;
+  SDL_Renderer *renderer;
+  // Everything is drawn here at the native resolution, then upscaled once
+  SDL_Texture *target;
   Sheets sheets;
   Screen screen;
-  Player player;
+  StaticLayer layer;
+  Hud hud;
+  World world;
+  Broadphase broadphase;
+  Contacts contacts;
+  ItemLists items;
+  Colliders colliders;
+  Snapshots snapshots;
+  HistoryWriter history;
+  Replay replay;
+  Latency latency;
+  Jobs jobs;
+  Assets assets;
+  // The level file being played
+  char *level;
+  Watcher watcher;
+  Sound sound;
+  Capture capture;
+  Scheduler scheduler;
+  Effects effects;
+  Memory memory;
+  SurfaceBackend surface;
+  Speed speed;
+  Idle idle;
+  Net net;
 } GameState;
 
 #endif
@@ -0,0 +1,273 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_rwops.h>
+#include "gameState.h"
+#include "history.h"
+
+// File layout: a header followed by one record per written world.
+// Every record holds the XOR of the world against the previous one, packed
+// as runs of (zeros, literal count, literal bytes). Keyframes are made
+// against an all zero world, so they can be decoded on their own.
+#define HISTORY_MAGIC 0x5348434d // "MCHS"
+#define HISTORY_VERSION 3
+#define HEADER_SIZE 12
+#define RECORD_HEADER_SIZE 9
+#define BUFFER_SIZE (sizeof(World) * 2 + 16)
+// Literals only stop at zero runs long enough to pay for a new run header
+#define MIN_ZERO_RUN 4
+
+enum { KEYFRAME = 'K', DELTA = 'D' };
+
+static void putU16(Uint8 *out, const Uint16 value) {
+  out[0] = value & 0xff;
+  out[1] = value >> 8;
+}
+
+static void putU32(Uint8 *out, const Uint32 value) {
+  putU16(out, value & 0xffff);
+  putU16(out + 2, value >> 16);
+}
+
+static Uint16 getU16(const Uint8 *in) { return in[0] | in[1] << 8; }
+
+static Uint32 getU32(const Uint8 *in) {
+  return getU16(in) | (Uint32)getU16(in + 2) << 16;
+}
+
+// XORs two worlds and run length encodes the result
+// @param base: The previous world, NULL for a keyframe
+// @return The size of the encoded data
+static uint encode(const World *base, const World *world, Uint8 *out) {
+  const Uint8 *a = (const Uint8 *)base, *b = (const Uint8 *)world;
+  const uint size = sizeof(World);
+  uint i = 0, length = 0;
+
+#define BYTE(j) (a ? a[j] ^ b[j] : b[j])
+  while (i < size) {
+    uint zeros = 0;
+    while (i < size && zeros < 0xffff && !BYTE(i)) {
+      zeros++;
+      i++;
+    }
+
+    const uint start = i;
+    uint literals = 0;
+    while (i < size && literals + MIN_ZERO_RUN < 0xffff) {
+      uint run = 0;
+      while (i + run < size && run < MIN_ZERO_RUN && !BYTE(i + run))
+        run++;
+      if (run == MIN_ZERO_RUN || i + run == size)
+        break;
+      literals += run + 1;
+      i += run + 1;
+    }
+
+    putU16(out + length, zeros);
+    putU16(out + length + 2, literals);
+    length += 4;
+    for (uint j = start; j < start + literals; j++)
+      out[length++] = BYTE(j);
+  }
+#undef BYTE
+
+  return length;
+}
+
+// Applies encoded data to a world by XORing the literals into it
+// @return false if the data is corrupted
+static bool decode(World *world, const Uint8 *in, const uint length) {
+  Uint8 *out = (Uint8 *)world;
+  uint i = 0, o = 0;
+
+  while (i + 4 <= length) {
+    const uint zeros = getU16(in + i), literals = getU16(in + i + 2);
+    i += 4;
+    o += zeros;
+    if (o + literals > sizeof(World) || i + literals > length)
+      return false;
+    for (uint j = 0; j < literals; j++)
+      out[o++] ^= in[i++];
+  }
+
+  return i == length;
+}
+
+// Creates a history file, overwriting it if it already exists
+// @return false if the file could not be created
+bool openHistoryWriter(HistoryWriter *writer, const char *path) {
+  writer->file = SDL_RWFromFile(path, "wb");
+  if (!writer->file) {
+    printf("Could not create the history! SDL_Error: %s\n", SDL_GetError());
+    return false;
+  }
+  writer->buffer = malloc(BUFFER_SIZE);
+  if (writer->buffer == NULL) {
+    printf("Could not allocate memory for the history\n");
+    SDL_RWclose(writer->file);
+    writer->file = NULL;
+    return false;
+  }
+
+  Uint8 header[HEADER_SIZE];
+  putU32(header, HISTORY_MAGIC);
+  putU32(header + 4, HISTORY_VERSION);
+  putU32(header + 8, sizeof(World));
+  SDL_RWwrite(writer->file, header, HEADER_SIZE, 1);
+  writer->count = 0;
+  writer->bytes = HEADER_SIZE;
+  return true;
+}
+
+// Appends a world to the history, as a keyframe every HISTORY_INTERVAL
+void writeHistory(HistoryWriter *writer, const World *world) {
+  if (!writer->file)
+    return;
+
+  const bool keyframe = writer->count % HISTORY_INTERVAL == 0;
+  const uint length =
+    encode(keyframe ? NULL : &writer->previous, world, writer->buffer);
+
+  Uint8 header[RECORD_HEADER_SIZE];
+  header[0] = keyframe ? KEYFRAME : DELTA;
+  putU32(header + 1, writer->count);
+  putU32(header + 5, length);
+  SDL_RWwrite(writer->file, header, RECORD_HEADER_SIZE, 1);
+  SDL_RWwrite(writer->file, writer->buffer, length, 1);
+
+  writer->previous = *world;
+  writer->count++;
+  writer->bytes += RECORD_HEADER_SIZE + length;
+}
+
+void closeHistoryWriter(HistoryWriter *writer) {
+  if (!writer->file)
+    return;
+
+  printf("History: %u ticks in %.2f MB\n",
+         writer->count,
+         writer->bytes / (1024.0 * 1024.0));
+  SDL_RWclose(writer->file);
+  free(writer->buffer);
+  writer->file = NULL;
+  writer->buffer = NULL;
+}
+
+// Opens a history file and indexes its keyframes
+// @return false if the file is missing or was made by another build
+bool openHistoryReader(HistoryReader *reader, const char *path) {
+  *reader = (HistoryReader) {0};
+  reader->file = SDL_RWFromFile(path, "rb");
+  if (!reader->file) {
+    printf("Could not open the history! SDL_Error: %s\n", SDL_GetError());
+    return false;
+  }
+
+  Uint8 header[HEADER_SIZE];
+  if (!SDL_RWread(reader->file, header, HEADER_SIZE, 1) ||
+      getU32(header) != HISTORY_MAGIC ||
+      getU32(header + 4) != HISTORY_VERSION ||
+      getU32(header + 8) != sizeof(World)) {
+    printf("The history %s is invalid or from another build\n", path);
+    closeHistoryReader(reader);
+    return false;
+  }
+
+  reader->buffer = malloc(BUFFER_SIZE);
+  uint capacity = 64;
+  reader->keys = malloc(sizeof(struct HistoryKey) * capacity);
+  if (reader->buffer == NULL || reader->keys == NULL) {
+    printf("Could not allocate memory for the history\n");
+    closeHistoryReader(reader);
+    return false;
+  }
+
+  Sint64 offset = HEADER_SIZE;
+  Uint8 record[RECORD_HEADER_SIZE];
+  while (SDL_RWread(reader->file, record, RECORD_HEADER_SIZE, 1)) {
+    if (record[0] == KEYFRAME) {
+      if (reader->keyCount == capacity) {
+        capacity *= 2;
+        struct HistoryKey *keys =
+          realloc(reader->keys, sizeof(struct HistoryKey) * capacity);
+        if (keys == NULL) {
+          printf("Could not allocate memory for the history\n");
+          closeHistoryReader(reader);
+          return false;
+        }
+        reader->keys = keys;
+      }
+      reader->keys[reader->keyCount++] =
+        (struct HistoryKey) {getU32(record + 1), offset};
+    }
+    reader->count = getU32(record + 1) + 1;
+    offset += RECORD_HEADER_SIZE + getU32(record + 5);
+    SDL_RWseek(reader->file, offset, RW_SEEK_SET);
+  }
+
+  return true;
+}
+
+// Reads the next record at reader->nextOffset and applies it
+static bool readRecord(HistoryReader *reader) {
+  Uint8 record[RECORD_HEADER_SIZE];
+  SDL_RWseek(reader->file, reader->nextOffset, RW_SEEK_SET);
+  if (!SDL_RWread(reader->file, record, RECORD_HEADER_SIZE, 1))
+    return false;
+
+  const uint length = getU32(record + 5);
+  if (length > BUFFER_SIZE ||
+      (length && !SDL_RWread(reader->file, reader->buffer, length, 1)))
+    return false;
+
+  if (record[0] == KEYFRAME)
+    reader->current = (World) {0};
+  if (!decode(&reader->current, reader->buffer, length))
+    return false;
+
+  reader->currentIndex = getU32(record + 1);
+  reader->nextOffset += RECORD_HEADER_SIZE + length;
+  return true;
+}
+
+// Rebuilds any entry by loading the nearest keyframe and applying deltas.
+// Seeking forward from the last entry only applies the deltas in between.
+// @return false if the entry is past the end or the file is corrupted
+bool seekHistory(HistoryReader *reader, const uint index, World *out) {
+  if (!reader->file || index >= reader->count)
+    return false;
+
+  // Binary search for the last keyframe at or before the index
+  uint low = 0, high = reader->keyCount;
+  while (high - low > 1) {
+    const uint middle = (low + high) / 2;
+    if (reader->keys[middle].index <= index)
+      low = middle;
+    else
+      high = middle;
+  }
+  const struct HistoryKey *key = &reader->keys[low];
+
+  if (!reader->decoded || reader->currentIndex > index ||
+      reader->currentIndex < key->index) {
+    reader->nextOffset = key->offset;
+    reader->decoded = false;
+  }
+
+  while (!reader->decoded || reader->currentIndex < index) {
+    if (!readRecord(reader)) {
+      reader->decoded = false;
+      return false;
+    }
+    reader->decoded = true;
+  }
+
+  *out = reader->current;
+  return true;
+}
+
+void closeHistoryReader(HistoryReader *reader) {
+  if (reader->file)
+    SDL_RWclose(reader->file);
+  free(reader->keys);
+  free(reader->buffer);
+  *reader = (HistoryReader) {0};
+}
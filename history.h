@@ -0,0 +1,13 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "gameState.h"
+
+bool openHistoryWriter(HistoryWriter *writer, const char *path);
+void writeHistory(HistoryWriter *writer, const World *world);
+void closeHistoryWriter(HistoryWriter *writer);
+bool openHistoryReader(HistoryReader *reader, const char *path);
+bool seekHistory(HistoryReader *reader, const uint index, World *out);
+void closeHistoryReader(HistoryReader *reader);
+
+#endif
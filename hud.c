@@ -0,0 +1,305 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_render.h>
+#include <string.h>
+#include "gameState.h"
+#include "hud.h"
+#include "scheduler.h"
+#include "surface.h"
+#include "utils.h"
+
+// Every glyph of the atlas in order, the blank one must stay first and the
+// digits right after it
+#define GLYPHS " 0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ-.:x/"
+#define GLYPH_COUNT (sizeof(GLYPHS) - 1)
+#define GLYPH_ROWS 7
+#define ATLAS_COLUMNS 16
+#define ATLAS_WIDTH (ATLAS_COLUMNS * GLYPH_SIZE)
+#define ATLAS_HEIGHT                                                           \
+  ((GLYPH_COUNT + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS * GLYPH_SIZE)
+
+// The countdown starts at this and goes down once every TIME_TICKS
+#define LEVEL_TIME 400
+#define TIME_TICKS 24
+
+// 5x7 pixels, the top bit of each row is the leftmost pixel
+static const Uint8 font[][GLYPH_ROWS] = {
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // Space
+  {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, // 0
+  {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, // 1
+  {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, // 2
+  {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, // 3
+  {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, // 4
+  {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, // 5
+  {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, // 6
+  {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // 7
+  {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, // 8
+  {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, // 9
+  {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // A
+  {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}, // B
+  {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}, // C
+  {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}, // D
+  {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}, // E
+  {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}, // F
+  {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}, // G
+  {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // H
+  {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, // I
+  {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}, // J
+  {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, // K
+  {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}, // L
+  {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}, // M
+  {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}, // N
+  {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // O
+  {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}, // P
+  {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}, // Q
+  {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}, // R
+  {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}, // S
+  {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, // T
+  {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // U
+  {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}, // V
+  {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}, // W
+  {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}, // X
+  {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04}, // Y
+  {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}, // Z
+  {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}, // -
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, // .
+  {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}, // :
+  {0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11}, // x
+  {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, // /
+};
+_Static_assert(sizeof(font) / sizeof(font[0]) == GLYPH_COUNT,
+               "Every glyph needs its pixels");
+
+// Draws the font into a white on transparent texture
+static void buildAtlas(GameState *state) {
+  static Uint32 pixels[ATLAS_HEIGHT][ATLAS_WIDTH];
+  for (uint i = 0; i < GLYPH_COUNT; i++) {
+    const uint x = i % ATLAS_COLUMNS * GLYPH_SIZE,
+               y = i / ATLAS_COLUMNS * GLYPH_SIZE;
+    for (uint row = 0; row < GLYPH_ROWS; row++) {
+      for (uint column = 0; column < 5; column++) {
+        if (font[i][row] >> (4 - column) & 1)
+          pixels[y + row][x + 1 + column] = 0xFFFFFFFF;
+      }
+    }
+  }
+
+  Hud *hud = &state->hud;
+  hud->atlas = SDL_CreateTexture(state->renderer,
+                                 SDL_PIXELFORMAT_ARGB8888,
+                                 SDL_TEXTUREACCESS_STATIC,
+                                 ATLAS_WIDTH,
+                                 ATLAS_HEIGHT);
+  if (!hud->atlas ||
+      SDL_UpdateTexture(hud->atlas, NULL, pixels, sizeof(pixels[0]))) {
+    printf("Could not create the glyph atlas! SDL_Error: %s\n",
+           SDL_GetError());
+    quit(state, 1);
+  }
+  SDL_SetTextureBlendMode(hud->atlas, SDL_BLENDMODE_BLEND);
+}
+
+// Points the texture coordinates of a quad at a glyph of the atlas
+static void setGlyph(SDL_Vertex quad[4], const uint glyph) {
+  const float u = (float)(glyph % ATLAS_COLUMNS * GLYPH_SIZE) / ATLAS_WIDTH,
+              v = (float)(glyph / ATLAS_COLUMNS * GLYPH_SIZE) / ATLAS_HEIGHT,
+              du = (float)GLYPH_SIZE / ATLAS_WIDTH,
+              dv = (float)GLYPH_SIZE / ATLAS_HEIGHT;
+  quad[0].tex_coord = (SDL_FPoint){u, v};
+  quad[1].tex_coord = (SDL_FPoint){u + du, v};
+  quad[2].tex_coord = (SDL_FPoint){u, v + dv};
+  quad[3].tex_coord = (SDL_FPoint){u + du, v + dv};
+}
+
+// @return The four vertices of a new blank glyph at x and y
+static SDL_Vertex *addGlyph(GameState *state,
+                            GlyphRun *run,
+                            const float x,
+                            const float y) {
+  if (run->count == MAX_HUD_GLYPHS) {
+    printf("The HUD has more than %d glyphs\n", MAX_HUD_GLYPHS);
+    quit(state, 1);
+  }
+
+  SDL_Vertex *quad = &run->vertices[run->count++ * 4];
+  const SDL_Color white = {255, 255, 255, 255};
+  quad[0] = (SDL_Vertex){{x, y}, white, {0, 0}};
+  quad[1] = (SDL_Vertex){{x + GLYPH_SIZE, y}, white, {0, 0}};
+  quad[2] = (SDL_Vertex){{x, y + GLYPH_SIZE}, white, {0, 0}};
+  quad[3] = (SDL_Vertex){{x + GLYPH_SIZE, y + GLYPH_SIZE}, white, {0, 0}};
+  setGlyph(quad, 0);
+  return quad;
+}
+
+// Characters missing from the atlas are left blank
+static void addLabel(GameState *state,
+                     const char *text,
+                     float x,
+                     const float y) {
+  for (; *text; text++, x += GLYPH_SIZE) {
+    const char *glyph = strchr(GLYPHS, *text);
+    setGlyph(addGlyph(state, &state->hud.labels, x, y),
+             glyph ? glyph - GLYPHS : 0);
+  }
+}
+
+// Reserves the glyphs of a number shown at x and y
+// @param digits: How many digits are shown, the lowest ones
+// @param decimals: How many of those come after the decimal point
+// @param zeros: Whether to pad with zeros instead of blanks
+static void addField(GameState *state,
+                     const HudField field,
+                     float x,
+                     const float y,
+                     const uint digits,
+                     const uint decimals,
+                     const bool zeros) {
+  Hud *hud = &state->hud;
+  const uint point = strchr(GLYPHS, '.') - GLYPHS;
+  hud->slots[field] = (struct HudSlot){.first = hud->fields.count,
+                                       .digits = digits,
+                                       .decimals = decimals,
+                                       .zeros = zeros,
+                                       .value = -1};
+
+  for (uint i = 0; i < digits; i++, x += GLYPH_SIZE) {
+    if (decimals && i == digits - decimals) {
+      setGlyph(addGlyph(state, &hud->fields, x, y), point);
+      x += GLYPH_SIZE;
+    }
+    addGlyph(state, &hud->fields, x, y);
+  }
+}
+
+// Swaps the glyphs of a field, only when its value changed
+static void setField(Hud *hud, const HudField field, int value) {
+  struct HudSlot *slot = &hud->slots[field];
+  if (value < 0)
+    value = 0;
+  if (value == slot->value)
+    return;
+  slot->value = value;
+
+  // From the lowest digit to the highest, hopping over the point
+  SDL_Vertex *quad = &hud->fields.vertices[slot->first * 4];
+  quad += (slot->digits + (slot->decimals ? 1 : 0) - 1) * 4;
+  for (uint i = 0; i < slot->digits; i++, quad -= 4) {
+    if (slot->decimals && i == slot->decimals)
+      quad -= 4;
+
+    const bool blank = !value && !slot->zeros && i > slot->decimals;
+    setGlyph(quad, blank ? 0 : 1 + value % 10);
+    value /= 10;
+  }
+}
+
+// Builds the atlas, the labels, and the layout of every field
+void initHud(GameState *state) {
+  Hud *hud = &state->hud;
+  buildAtlas(state);
+
+  for (uint i = 0; i < MAX_HUD_GLYPHS; i++) {
+    const int quad[6] = {0, 1, 2, 2, 1, 3};
+    for (uint j = 0; j < 6; j++)
+      hud->indices[i * 6 + j] = i * 4 + quad[j];
+  }
+
+  addLabel(state, "MARIO", 24, 8);
+  addField(state, HUD_SCORE, 24, 16, 6, 0, true);
+  addLabel(state, "x", 96, 16);
+  addField(state, HUD_COINS, 104, 16, 2, 0, true);
+  addLabel(state, "TIME", 200, 8);
+  addField(state, HUD_TIME, 208, 16, 3, 0, true);
+  addLabel(state, "FPS", 24, 32);
+  addField(state, HUD_FPS, 56, 32, 3, 0, false);
+  addLabel(state, "MS", 128, 32);
+  addField(state, HUD_FRAME_TIME, 88, 32, 3, 1, false);
+  addLabel(state, "TPS", 24, 40);
+  addField(state, HUD_TPS, 56, 40, 6, 0, false);
+}
+
+// The round trip and the traffic, only shown when playing over the network
+void initNetHud(GameState *state) {
+  addLabel(state, "PING", 24, 48);
+  addField(state, HUD_PING, 64, 48, 3, 0, false);
+  addLabel(state, "MS", 96, 48);
+  addLabel(state, "B/S", 200, 48);
+  addField(state, HUD_NET_RATE, 152, 48, 5, 0, false);
+}
+
+// Updates the numbers of the HUD, once per frame
+void updateHud(GameState *state) {
+  Hud *hud = &state->hud;
+  const Player *player = &state->world.players[state->net.local];
+
+  // Smoothed so the readout stays legible
+  if (!hud->frameTime)
+    hud->frameTime = 1.0f / TICK_RATE;
+  if (state->screen.deltaTime > 0)
+    hud->frameTime += (state->screen.deltaTime - hud->frameTime) * 0.05f;
+
+  if (scheduleWork(state, WORK_COSMETIC)) {
+    setField(hud, HUD_SCORE, player->score);
+    setField(hud, HUD_COINS, player->coins);
+    setField(
+      hud, HUD_TIME, LEVEL_TIME - (int)(state->world.tick / TIME_TICKS));
+    setField(hud, HUD_FPS, 1 / hud->frameTime + 0.5f);
+    setField(hud, HUD_FRAME_TIME, hud->frameTime * 1e4f + 0.5f);
+    setField(hud, HUD_TPS, state->speed.ticksPerSecond);
+    if (state->net.enabled) {
+      setField(hud, HUD_PING, state->net.rtt + 0.5f);
+      setField(hud, HUD_NET_RATE, state->net.bytesPerSecond);
+    }
+  }
+}
+
+// @return The rectangle around a number of quads
+static SDL_FRect quadBounds(const SDL_Vertex *quads, const uint count) {
+  SDL_FPoint min = quads[0].position, max = quads[0].position;
+  for (uint i = 1; i < count * 4; i++) {
+    const SDL_FPoint *point = &quads[i].position;
+    min.x = point->x < min.x ? point->x : min.x;
+    min.y = point->y < min.y ? point->y : min.y;
+    max.x = point->x > max.x ? point->x : max.x;
+    max.y = point->y > max.y ? point->y : max.y;
+  }
+  return (SDL_FRect){min.x, min.y, max.x - min.x, max.y - min.y};
+}
+
+// Draws the whole HUD in two calls, one for the labels and one for the
+// numbers
+void renderHud(GameState *state) {
+  Hud *hud = &state->hud;
+  const SDL_FRect labels = quadBounds(hud->labels.vertices, hud->labels.count),
+                  fields = quadBounds(hud->fields.vertices, hud->fields.count);
+
+  // Each field only changes with its value
+  traceSprite(state, &labels, spriteKey(hud->atlas, NULL, 0));
+  for (uint i = 0; i < HUD_FIELDS; i++) {
+    const struct HudSlot *slot = &hud->slots[i];
+    const SDL_FRect bounds =
+      quadBounds(&hud->fields.vertices[slot->first * 4],
+                 slot->digits + (slot->decimals ? 1 : 0));
+    traceSprite(state, &bounds, spriteKey(hud->atlas, NULL, slot->value));
+  }
+
+  for (uint cursor = 0; clipSprite(state, &labels, &cursor);)
+    SDL_RenderGeometry(state->renderer,
+                       hud->atlas,
+                       hud->labels.vertices,
+                       hud->labels.count * 4,
+                       hud->indices,
+                       hud->labels.count * 6);
+  for (uint cursor = 0; clipSprite(state, &fields, &cursor);)
+    SDL_RenderGeometry(state->renderer,
+                       hud->atlas,
+                       hud->fields.vertices,
+                       hud->fields.count * 4,
+                       hud->indices,
+                       hud->fields.count * 6);
+}
+
+void freeHud(GameState *state) {
+  if (state->hud.atlas)
+    SDL_DestroyTexture(state->hud.atlas);
+  state->hud.atlas = NULL;
+}
@@ -0,0 +1,12 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include "gameState.h"
+
+void initHud(GameState *state);
+void initNetHud(GameState *state);
+void updateHud(GameState *state);
+void renderHud(GameState *state);
+void freeHud(GameState *state);
+
+#endif
@@ -0,0 +1,130 @@
+#include <SDL2/SDL.h>
+#include <time.h>
+#include "gameState.h"
+#include "idle.h"
+#include "input.h"
+#include "render.h"
+#include "scheduler.h"
+#include "surface.h"
+#include "watch.h"
+
+// Longest sleep while idle, the level file is still watched this often
+#define IDLE_TIMEOUT 250
+
+static const char *modeNames[POWER_MODES] = {
+  [MODE_ACTIVE] = "Active",
+  [MODE_BACKGROUND] = "In the background",
+  [MODE_MINIMIZED] = "Minimized",
+};
+
+// Call this right before the main loop, the window events seen until then
+// are kept
+void initIdle(GameState *state) {
+  Idle *idle = &state->idle;
+  idle->measuring = true;
+  idle->modeStart = SDL_GetTicks();
+  idle->cpuStart = clock();
+}
+
+// Assumed focused, not every system says so when the window opens
+void initWindowState(GameState *state) {
+  state->idle = (Idle){.focused = true, .mode = MODE_ACTIVE};
+}
+
+// Adds the time since the last switch to the mode it was in
+static void switchMode(Idle *idle, const PowerMode mode) {
+  const Uint32 now = SDL_GetTicks();
+  const clock_t cpu = clock();
+
+  idle->wallTime[idle->mode] += now - idle->modeStart;
+  idle->cpuTime[idle->mode] += cpu - idle->cpuStart;
+  idle->modeStart = now;
+  idle->cpuStart = cpu;
+  idle->mode = mode;
+}
+
+// Keeps track of whether the window is minimized or focused
+void handleWindowEvent(GameState *state, const SDL_WindowEvent *event) {
+  Idle *idle = &state->idle;
+
+  switch (event->event) {
+    case SDL_WINDOWEVENT_FOCUS_GAINED:
+      idle->focused = true;
+      break;
+    case SDL_WINDOWEVENT_FOCUS_LOST:
+      idle->focused = false;
+      break;
+    case SDL_WINDOWEVENT_MINIMIZED:
+      idle->minimized = true;
+      break;
+    case SDL_WINDOWEVENT_RESTORED:
+    case SDL_WINDOWEVENT_MAXIMIZED:
+      idle->minimized = false;
+      break;
+    case SDL_WINDOWEVENT_EXPOSED:
+      // What was on the window surface is gone
+      invalidateSurface(state);
+      idle->exposed = true;
+      break;
+  }
+
+  const PowerMode mode = idle->minimized ? MODE_MINIMIZED
+                         : idle->focused ? MODE_ACTIVE
+                                         : MODE_BACKGROUND;
+  if (mode == idle->mode)
+    return;
+  if (idle->measuring)
+    switchMode(idle, mode);
+  else
+    idle->mode = mode;
+}
+
+// Sleeps while the window is minimized or unfocused, nothing is simulated
+// meanwhile. A window that can still be seen is drawn again when it gets
+// uncovered.
+// @return Whether it slept, the frame timing has to start over then so
+// the time away is not caught up on
+bool waitWhileIdle(GameState *state) {
+  Idle *idle = &state->idle;
+  // The other player would be stuck waiting for this one
+  if (idle->mode == MODE_ACTIVE || state->net.enabled)
+    return false;
+
+  while (idle->mode != MODE_ACTIVE) {
+    // Only waits, the events are taken by handleEvents()
+    SDL_WaitEventTimeout(NULL, IDLE_TIMEOUT);
+    idle->wakeups[idle->mode]++;
+    idle->exposed = false;
+    handleEvents(state);
+    pollWatcher(state);
+
+    if (idle->exposed && idle->mode == MODE_BACKGROUND) {
+      beginFrame(state);
+      render(state);
+    }
+  }
+  return true;
+}
+
+void printIdle(GameState *state) {
+  Idle *idle = &state->idle;
+  if (!idle->measuring)
+    return;
+
+  switchMode(idle, idle->mode);
+
+  for (uint i = 0; i < POWER_MODES; i++) {
+    if (!idle->wallTime[i])
+      continue;
+
+    const double seconds = idle->wallTime[i] / 1000.0;
+    const double cpu = (double)idle->cpuTime[i] / CLOCKS_PER_SEC;
+    printf("%s for %.1f s: %.1f%% of a core",
+           modeNames[i],
+           seconds,
+           cpu * 100 / seconds);
+    if (i != MODE_ACTIVE)
+      printf(", woke up %.1f times per second", idle->wakeups[i] / seconds);
+    printf("\n");
+  }
+}
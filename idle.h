@@ -0,0 +1,12 @@
+#ifndef IDLE_H
+#define IDLE_H
+
+#include "gameState.h"
+
+void initWindowState(GameState *state);
+void initIdle(GameState *state);
+void handleWindowEvent(GameState *state, const SDL_WindowEvent *event);
+bool waitWhileIdle(GameState *state);
+void printIdle(GameState *state);
+
+#endif
@@ -1,132 +1,53 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_rect.h>
+#include "assets.h"
 #include "gameState.h"
+#include "hud.h"
+#include "jobs.h"
+#include "level.h"
+#include "layer.h"
+#include "memory.h"
+#include "snapshot.h"
+#include "surface.h"
 #include "utils.h"
-
-// TODO: Add an interrogation block with a single coin
-// Create a block in state.blocks
-void createBlock(GameState *state,
-                 const int x,
-                 const int y,
-                 const BlockState tBlock,
-                 const ItemType tItem) {
-  BlockSprite sprite = INTERROGATION_SPRITE;
-  if (tBlock == NOTHING || tItem == COINS)
-    sprite = BRICK_SPRITE;
-
-  ushort iw = state->screen.tile;
-  if (tItem == COINS)
-    iw /= 2;
-
-  Block *block = &state->blocks[state->blocksLenght];
-  *block = (Block) {
-    .rect = (SDL_FRect) {x, y, state->screen.tile, state->screen.tile},
-    .initY = y,
-    .gotHit = false,
-    .broken = false,
-    .type = tBlock,
-    .sprite = sprite,
-  };
-  state->blocksLenght++;
-
-  if (tBlock == NOTHING) {
-    block->item = (Item) {{0, 0, 0, 0}, {0, 0}, false, false, false, 0};
-    const float size = state->screen.tile / 2.0;
-
-    for (ushort i = 0; i < MAX_BLOCK_PARTICLES; i++) {
-      struct Particle *particle = &block->particles[i];
-
-      // Defining the particles X values by column
-      if (i % 2 == 0) {
-        particle->rect.x = x;
-        particle->velocity.x = -MAX_SPEED * 0.5f;
-      } else {
-        particle->rect.x = x + size;
-        particle->velocity.x = MAX_SPEED * 0.5f;
-      }
-
-      // Defining the particles Y values by row
-      if (i < 2) {
-        particle->rect.y = y;
-        particle->velocity.y = MAX_JUMP * 1.15f;
-      } else {
-        particle->rect.y = y + size;
-        particle->velocity.y = MAX_JUMP;
-      }
-
-      particle->rect.w = size;
-      particle->rect.h = size;
-    }
-
-    return;
-  } else if (tItem == COINS) {
-    block->maxCoins = 10;
-    block->coinCount = block->maxCoins;
-
-    for (ushort i = 0; i < block->maxCoins; i++) {
-      block->coins[i] = (Coin) {
-        .rect = {x + iw / 2.0, y, iw, state->screen.tile},
-        .onAir = false,
-        .willFall = false,
-      };
-    }
-  }
-
-  block->item = (Item) {
-    .velocity = {ITEM_SPEED, 0},
-    .rect = {x, y, iw, state->screen.tile},
-    .type = tItem,
-    .free = false,
-    .visible = true,
-  };
-}
-
-void initObjs(GameState *state) {
-  Screen *screen = &state->screen;
-  ushort tile = screen->tile;
-
-  state->blocksLenght = 0;
-  state->objsLength = 6;
-
-  createBlock(state, tile, screen->h - tile * 3, NOTHING, false);
-  createBlock(
-    state, screen->w / 2 - tile * 2, screen->h - tile * 5, NOTHING, false);
-  createBlock(
-    state, screen->w / 2 - tile, screen->h - tile * 5, FULL, MUSHROOM);
-  createBlock(state, screen->w / 2, screen->h - tile * 5, FULL, FIRE_FLOWER);
-  createBlock(state, screen->w / 2 + tile, screen->h - tile * 5, FULL, COINS);
-  createBlock(
-    state, screen->w / 2 + tile * 2, screen->h - tile * 5, FULL, STAR);
+#include "watch.h"
+
+Num GRAVITY, MAX_GRAVITY, SPEED, MAX_SPEED, JUMP_FORCE, MAX_JUMP, ITEM_SPEED,
+  ITEM_JUMP_FORCE, BLOCK_SPEED, ENEMY_SPEED;
+
+// Scales the physics constants, tuned for 64 pixel tiles, to the tile size
+void initPhysics(const ushort tile) {
+#define SCALED(value) (NUM(value) * tile / 64)
+  GRAVITY = SCALED(0.8f);
+  MAX_GRAVITY = SCALED(20);
+  SPEED = SCALED(0.2f);
+  MAX_SPEED = SCALED(7);
+  JUMP_FORCE = SCALED(2.5f);
+  MAX_JUMP = SCALED(-15);
+  ITEM_SPEED = SPEED * 12;
+  ITEM_JUMP_FORCE = JUMP_FORCE * 6;
+  BLOCK_SPEED = SCALED(3);
+  ENEMY_SPEED = SCALED(2);
+#undef SCALED
 }
 
-// Initialize the textures on the state.sheets, as well as the srcs.
+// Requests the textures of state.sheets, which arrive over the next frames,
+// and sets up the srcs.
 void initTextures(GameState *state) {
-  const char *path = "./assets/sprites/";
+  const char *path = SPRITES_PATH;
   Sheets *sheets = &state->sheets;
   char *files[] = {"mario.png", "objs.png", "items.png", "effects.png"};
 
+  SDL_Texture **textures[] = {
+    &sheets->mario, &sheets->objs, &sheets->items, &sheets->effects};
+  // Only Mario is ever drawn flipped
+  SDL_Texture **mirrored[] = {&sheets->marioMirrored, NULL, NULL, NULL};
+
+  // Decoded on the loader thread, the first frames show the loading state
   for (uint i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
     char *filePath = catpath(state, path, files[i]);
-    SDL_RWops *fileRW = SDL_RWFromFile(filePath, "r");
-    if (!fileRW) {
-      printf("Could not load the sprites! SDL_Error: %s\n", SDL_GetError());
-      quit(state, 1);
-    }
-    SDL_Texture *fileTexture =
-      IMG_LoadTextureTyped_RW(state->renderer, fileRW, 1, "PNG");
-    if (i == 0)
-      sheets->mario = fileTexture;
-    else if (i == 1)
-      sheets->objs = fileTexture;
-    else if (i == 2)
-      sheets->items = fileTexture;
-    else if (i == 3)
-      sheets->effects = fileTexture;
-    if (!fileTexture) {
-      printf("Could not place the sprites! SDL_Error: %s\n", SDL_GetError());
-      quit(state, 1);
-    }
+    requestAsset(state, filePath, textures[i], mirrored[i]);
     free(filePath);
     filePath = NULL;
   }
@@ -184,53 +105,17 @@ void initTextures(GameState *state) {
   getsrcs(sheets->srceffects, 4, &effectsFCount, 2, 1, 1, false, false);
 }
 
-void initGame(GameState *state) {
-  if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0) {
-    printf("Could not initialize SDL! SDL_Error: %s\n", SDL_GetError());
-    exit(1);
-  }
-  if (IMG_Init(IMG_INIT_PNG) < 0) {
-    printf("Could not initialize IMG! IMG_Error: %s\n", SDL_GetError());
-    exit(1);
-  }
-  Screen screen = {.w = 640, // TODO: Screen resizing
-                   .h = 480,
-                   .tile = 64,
-                   .deltaTime = 0, // DeltaTime
-                   .targetFps = 60,
-                   .xformTimer = 0,
-                   .starTimer = 0,
-                   .firingTimer = 0};
-  state->screen = screen;
-
-  SDL_Window *window = SDL_CreateWindow("Mario Bros Demo",
-                                        SDL_WINDOWPOS_UNDEFINED,
-                                        SDL_WINDOWPOS_UNDEFINED,
-                                        screen.w,
-                                        screen.h,
-                                        SDL_WINDOW_SHOWN);
-  if (!window) {
-    printf("Window could not be created! SDL_Error: %s\n", SDL_GetError());
-    SDL_Quit();
-    exit(1);
-  }
-  state->window = window;
-
-  // TODO: Have option to choose fps limit instead of vsync
-  SDL_Renderer *renderer = SDL_CreateRenderer(
-    window, -1, SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_ACCELERATED);
-  if (!renderer) {
-    printf("Renderer could not be created! SDL_Error: %s\n", SDL_GetError());
-    quit(state, 1);
-  }
-  state->renderer = renderer;
-
+// A small player at the start position of the given slot
+static Player spawnPlayer(const Screen *screen, const uint index) {
   // TODO: Alter fixed position start later
-  ushort tile = screen.tile;
-  SDL_FRect prect = {screen.w / 2.0 - tile, screen.h - tile * 3, tile, tile};
+  const Num tile = NUM(screen->tile);
+  Box prect = {NUM(screen->w) / 2 - tile + tile * (int)index,
+               NUM(screen->h) - tile * 3,
+               tile,
+               tile};
   Player player = {
     .rect = prect,
-    .hitbox = {prect.x + tile / 4.0, prect.y, tile / 2.0, prect.h},
+    .hitbox = {prect.x + tile / 4, prect.y, tile / 2, prect.h},
     .velocity = {0, 0},
     .tall = false,
     .fireForm = false,
@@ -242,17 +127,113 @@ void initGame(GameState *state) {
 
   for (ushort i = 0; i < MAX_FIREBALLS; i++) {
     player.fireballs[i] = (Fireball) {
-      .rect = (SDL_FRect) {0, prect.y, screen.tile / 2.0, screen.tile / 2.0},
+      .rect = (Box) {0, prect.y, tile / 2, tile / 2},
       .velocity = {0, MAX_SPEED},
       .visible = false};
   }
 
-  state->player = player;
-
   if (player.tall || player.fireForm) {
     player.rect.h += tile;
     player.rect.y -= tile;
   }
+  return player;
+}
+
+// Puts a new small player in the world, a tile right of the last one
+// @return false when the world has no room for another
+bool addPlayer(GameState *state) {
+  World *world = &state->world;
+  const uint index = world->playerCount;
+  if (index == MAX_PLAYERS)
+    return false;
+
+  world->players[index] = spawnPlayer(&state->screen, index);
+  world->lastInput[index] = 0;
+  world->holdingJump[index] = false;
+  world->playerCount++;
+  return true;
+}
+
+// Sends a player back to its start position, small, keeping its score and
+// coins
+void resetPlayer(GameState *state, const uint index) {
+  Player *player = &state->world.players[index];
+  Player reset = spawnPlayer(&state->screen, index);
+  reset.coins = player->coins;
+  reset.score = player->score;
+  *player = reset;
+}
+
+void initGame(GameState *state) {
+  countAllocations();
+  if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0) {
+    printf("Could not initialize SDL! SDL_Error: %s\n", SDL_GetError());
+    exit(1);
+  }
+  if (IMG_Init(IMG_INIT_PNG) < 0) {
+    printf("Could not initialize IMG! IMG_Error: %s\n", SDL_GetError());
+    exit(1);
+  }
+  state->level = catpath(state, DEFAULT_LEVEL, "");
+  initWatcher(state);
+
+  Screen screen = {.w = NATIVE_WIDTH,
+                   .h = NATIVE_HEIGHT,
+                   .tile = NATIVE_TILE,
+                   .deltaTime = 0, // DeltaTime
+                   .targetFps = TICK_RATE};
+  state->screen = screen;
+  initPhysics(screen.tile);
+
+  SDL_Window *window =
+    SDL_CreateWindow("Mario Bros Demo",
+                     SDL_WINDOWPOS_UNDEFINED,
+                     SDL_WINDOWPOS_UNDEFINED,
+                     screen.w * WINDOW_SCALE,
+                     screen.h * WINDOW_SCALE,
+                     SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
+  if (!window) {
+    printf("Window could not be created! SDL_Error: %s\n", SDL_GetError());
+    SDL_Quit();
+    exit(1);
+  }
+  state->window = window;
+
+  // TODO: Have option to choose fps limit instead of vsync
+  if (!state->surface.enabled) {
+    state->renderer = SDL_CreateRenderer(
+      window, -1, SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_ACCELERATED);
+    if (!state->renderer)
+      printf("Renderer could not be created, drawing to the window surface "
+             "instead! SDL_Error: %s\n",
+             SDL_GetError());
+  }
+  if (!state->renderer) {
+    // Software only, it already draws at the native resolution
+    initSurfaceBackend(state);
+  } else {
+    // Without render targets SDL scales every draw to the window instead
+    state->target = SDL_CreateTexture(state->renderer,
+                                      SDL_PIXELFORMAT_RGBA8888,
+                                      SDL_TEXTUREACCESS_TARGET,
+                                      screen.w,
+                                      screen.h);
+    if (!state->target) {
+      SDL_RenderSetLogicalSize(state->renderer, screen.w, screen.h);
+      SDL_RenderSetIntegerScale(state->renderer, SDL_TRUE);
+    }
+  }
+
+  state->world.playerCount = 0;
+  addPlayer(state);
+  state->world.tick = 0;
+  initAssets(state);
   initTextures(state);
-  initObjs(state);
+  initArenas(state);
+  if (!loadLevel(state, state->level))
+    quit(state, 1);
+  initStaticLayer(state);
+  initHud(state);
+  initSnapshots(state);
+  initJobs(&state->jobs, SDL_GetCPUCount());
 }
@@ -3,6 +3,8 @@
 
 #include "gameState.h"
 
+bool addPlayer(GameState *state);
+void resetPlayer(GameState *state, const uint index);
 void initGame(GameState *state);
 
 #endif
@@ -2,13 +2,22 @@
 #include <SDL2/SDL_keycode.h>
 #include <SDL2/SDL_scancode.h>
 #include "gameState.h"
+#include "idle.h"
+#include "latency.h"
+#include "layer.h"
+#include "snapshot.h"
+#include "sound.h"
+#include "speed.h"
+#include "timeline.h"
 #include "utils.h"
 
-// Takes care of all the events of the game.
-void handleEvents(GameState *state) {
+// Takes care of all the events of the game and samples the buttons held
+// for the next tick.
+// @return The buttons to feed into tick()
+Input handleEvents(GameState *state) {
   SDL_Event event;
-  Player *player = &state->player;
-  static bool holdingJump = false;
+  // SDL_GetTicks() time of the oldest key event
+  Uint32 oldestKey = 0;
 
   while (SDL_PollEvent(&event)) {
     switch (event.type) {
@@ -18,98 +27,148 @@ void handleEvents(GameState *state) {
       case SDL_WINDOWEVENT_CLOSE:
         quit(state, 0);
         break;
+      case SDL_WINDOWEVENT:
+        handleWindowEvent(state, &event.window);
+        break;
+      case SDL_RENDER_TARGETS_RESET:
+      case SDL_RENDER_DEVICE_RESET:
+        invalidateStaticLayer(state);
+        break;
+      case SDL_KEYUP:
+        if (!oldestKey)
+          oldestKey = event.key.timestamp;
+        break;
       case SDL_KEYDOWN:
         if (event.key.repeat != 0)
           break;
+        if (!oldestKey)
+          oldestKey = event.key.timestamp;
         switch (event.key.keysym.sym) {
           case SDLK_ESCAPE:
             quit(state, 0);
             break;
-          case SDLK_f: {
-            if (!player->fireForm || player->crounching || player->firing)
-              break;
-
-            // Finding an available fireball slot
-            ushort ballCount = 0, emptySlot = 0;
-            for (ushort i = 0; i < MAX_FIREBALLS; i++) {
-              if (player->fireballs[i].visible)
-                ballCount++;
-              else {
-                emptySlot = i;
-                break;
-              }
-            }
-
-            if (ballCount < MAX_FIREBALLS) {
-              Fireball *ball = &player->fireballs[emptySlot];
-
-              if (player->facingRight) {
-                ball->rect.x = player->rect.x + player->rect.w;
-                ball->velocity.x = MAX_SPEED;
-              } else {
-                ball->rect.x = player->rect.x;
-                ball->velocity.x = -MAX_SPEED;
-              }
-
-              ball->rect.y = player->rect.y;
-              ball->velocity.y = MAX_SPEED;
-              ball->visible = true;
-
-              if (player->firing)
-                state->screen.firingTimer = 0;
-              player->firing = true;
-            }
+          case SDLK_F5:
+            saveState(state);
+            break;
+          // Going back or ahead would leave the other player behind
+          case SDLK_F9:
+            if (!state->net.enabled)
+              loadState(state);
+            break;
+          case SDLK_TAB:
+            if (!state->net.enabled)
+              toggleFastForward(state);
             break;
-          }
         }
-      case SDL_KEYUP: {
-        if (event.key.repeat != 0)
-          break;
+        break;
+    }
+  }
 
-        const SDL_Keycode keyup = event.key.keysym.sym;
-        if ((player->jumping || !player->velocity.y) &&
-            (keyup == SDLK_SPACE || keyup == SDLK_w || keyup == SDLK_UP)) {
-          if (player->velocity.y < 0)
-            player->velocity.y = player->velocity.y * 0.5;
-          else
-            holdingJump = false;
-        }
+  Input input = 0;
+  const Uint8 *key = SDL_GetKeyboardState(NULL);
 
-        if (keyup == SDLK_s || keyup == SDLK_DOWN) {
-          player->crounching = false;
-        }
+  if (key[SDL_SCANCODE_LEFT] || key[SDL_SCANCODE_A])
+    input |= INPUT_LEFT;
+  if (key[SDL_SCANCODE_RIGHT] || key[SDL_SCANCODE_D])
+    input |= INPUT_RIGHT;
+  if (key[SDL_SCANCODE_DOWN] || key[SDL_SCANCODE_S])
+    input |= INPUT_DOWN;
+  if (key[SDL_SCANCODE_UP])
+    input |= INPUT_UP;
+  if (key[SDL_SCANCODE_UP] || key[SDL_SCANCODE_W] || key[SDL_SCANCODE_SPACE])
+    input |= INPUT_JUMP;
+  if (key[SDL_SCANCODE_F])
+    input |= INPUT_FIRE;
+
+  state->snapshots.rewinding = key[SDL_SCANCODE_R] && !state->net.enabled;
+
+  // Count the time the key events waited in the queue as latency too
+  Uint64 stamp = SDL_GetPerformanceCounter();
+  const Uint32 ticks = SDL_GetTicks();
+  if (oldestKey && oldestKey <= ticks)
+    stamp -= (Uint64)(ticks - oldestKey) * SDL_GetPerformanceFrequency() / 1000;
+  markInput(state, input, stamp);
+  return input;
+}
+
+// Applies the buttons of one tick to a player. Presses and releases are
+// found by comparing with the input of the previous tick.
+void applyInput(GameState *state, const uint index, const Input input) {
+  World *world = &state->world;
+  Player *player = &world->players[index];
+  const Input pressed = input & ~world->lastInput[index],
+              changed = input ^ world->lastInput[index];
+  world->lastInput[index] = input;
+
+  if ((pressed & INPUT_FIRE) && player->fireForm && !player->crounching &&
+      !player->firing) {
+    // Finding an available fireball slot
+    ushort ballCount = 0, emptySlot = 0;
+    for (ushort i = 0; i < MAX_FIREBALLS; i++) {
+      if (player->fireballs[i].visible)
+        ballCount++;
+      else {
+        emptySlot = i;
         break;
       }
     }
+
+    if (ballCount < MAX_FIREBALLS) {
+      Fireball *ball = &player->fireballs[emptySlot];
+
+      if (player->facingRight) {
+        ball->rect.x = player->rect.x + player->rect.w;
+        ball->velocity.x = MAX_SPEED;
+      } else {
+        ball->rect.x = player->rect.x;
+        ball->velocity.x = -MAX_SPEED;
+      }
+
+      ball->rect.y = player->rect.y;
+      ball->velocity.y = MAX_SPEED;
+      ball->visible = true;
+      playSound(state, SOUND_FIREBALL);
+
+      player->firing = true;
+      startSequence(world, SEQUENCE_FIRING, index, 0);
+    }
+  }
+
+  if ((changed & INPUT_JUMP) && (player->jumping || !player->velocity.y)) {
+    if (player->velocity.y < 0)
+      player->velocity.y = player->velocity.y / 2;
+    else
+      world->holdingJump[index] = false;
   }
 
+  if (changed & INPUT_DOWN)
+    player->crounching = false;
+
   bool walkPressed = false;
-  const Uint8 *key = SDL_GetKeyboardState(NULL);
 
-  if (!player->crounching && (key[SDL_SCANCODE_LEFT] || key[SDL_SCANCODE_A])) {
+  if (!player->crounching && (input & INPUT_LEFT)) {
     player->facingRight = false;
     player->walking = true;
     walkPressed = true;
 
     if (player->velocity.x > 0)
-      player->velocity.x *= FRIC;
+      player->velocity.x = NUM_MUL(player->velocity.x, FRIC);
     if (player->velocity.x > -MAX_SPEED)
       player->velocity.x -= SPEED;
-  } else if (!player->crounching &&
-             (key[SDL_SCANCODE_RIGHT] || key[SDL_SCANCODE_D])) {
+  } else if (!player->crounching && (input & INPUT_RIGHT)) {
     player->facingRight = true;
     player->walking = true;
     walkPressed = true;
 
     if (player->velocity.x < 0)
-      player->velocity.x *= FRIC;
+      player->velocity.x = NUM_MUL(player->velocity.x, FRIC);
     if (player->velocity.x < MAX_SPEED)
       player->velocity.x += SPEED;
   } else {
     if (player->velocity.x) {
-      player->velocity.x *= FRIC;
+      player->velocity.x = NUM_MUL(player->velocity.x, FRIC);
 
-      if (fabsf(player->velocity.x) < 0.1f)
+      if (NUM_ABS(player->velocity.x) < SPEED / 2)
         player->velocity.x = 0;
     } else
       player->walking = false;
@@ -117,14 +176,16 @@ void handleEvents(GameState *state) {
   }
 
   if (!player->velocity.y && !walkPressed && player->tall &&
-      (key[SDL_SCANCODE_DOWN] || key[SDL_SCANCODE_S])) {
+      (input & INPUT_DOWN)) {
     player->crounching = true;
   }
 
-  if (player->onSurface && !holdingJump && key[SDL_SCANCODE_UP]) {
-    player->velocity.y = MAX_JUMP * 1.25;
+  if (player->onSurface && !world->holdingJump[index] &&
+      (input & INPUT_UP)) {
+    player->velocity.y = NUM_MUL(MAX_JUMP, NUM(1.25));
     player->jumping = true;
-    holdingJump = true;
+    world->holdingJump[index] = true;
+    playSound(state, SOUND_JUMP);
   }
 
   // NOTES: TEMPORARY CEILING AND LEFT WALL
@@ -3,6 +3,7 @@
 
 #include "gameState.h"
 
-void handleEvents(GameState *state);
+Input handleEvents(GameState *state);
+void applyInput(GameState *state, const uint index, const Input input);
 
 #endif
@@ -0,0 +1,326 @@
+#include <SDL2/SDL.h>
+#include "collision.h"
+#include "gameState.h"
+#include "items.h"
+#include "jobs.h"
+
+// Items moved per job, a level's worth fits in one
+#define MOVE_GRAIN 32
+// Items checked per job
+#define ITEM_GRAIN 8
+_Static_assert((MAX_BLOCKS + ITEM_GRAIN - 1) / ITEM_GRAIN <= CONTACT_CHUNKS,
+               "Every item detection job needs its own contact chunk");
+
+const ItemBehavior itemBehaviors[ITEM_TYPES] = {
+#define X(type, name, powerUp, moves, hops, frames, period, firstFrame)        \
+  [type] = {powerUp, moves, hops, frames, period, firstFrame},
+  ITEM_BEHAVIORS(X)
+#undef X
+};
+
+// Sorts the blocks with a moving item into the list of its type, a free
+// item that stays on its block and one not out of it yet are left out
+void partitionItems(GameState *state) {
+  const World *world = &state->world;
+  ItemLists *items = &state->items;
+
+  for (uint t = 0; t < ITEM_TYPES; t++)
+    items->count[t] = 0;
+
+  for (uint i = 0; i < world->blocksLenght; i++) {
+    const Block *block = &world->blocks[i];
+    const Item *item = &block->item;
+
+    items->contactCount[i] = 0;
+    if (itemBehaviors[item->type].moves && item->free && item->visible &&
+        block->type == EMPTY)
+      items->blocks[item->type][items->count[item->type]++] = i;
+  }
+}
+
+// @param now: The time of the world in milliseconds
+// @return The frame of the items sheet, a still one until it is free
+ushort itemFrame(const Item *item, const uint now) {
+  const ItemBehavior *behavior = &itemBehaviors[item->type];
+
+  if (!item->free)
+    return behavior->firstFrame;
+  return behavior->firstFrame + now / behavior->period % behavior->frames;
+}
+
+// The item trick below is not a real collision, the object stops the item
+// once it is low enough
+static int itemObjectCollision(const Item *item, const Box *object) {
+  // ERROR: Using collision() in a if statement causes weird behaviour
+  // ERROR: Using its value in !result or resolveCollision() causes weirder
+  // behaviour const int result = collision(item->rect, item->velocity,
+  // *object, state->screen.tile / 2); NOTE: Temporary trick to stop item
+  // hopping
+  return item->rect.y > object->y - NUM_MUL(item->rect.h, NUM(1.25)) ? -1 : 0;
+}
+
+// The kernels below run over the list of one type, they are specialized
+// to each type further down
+
+static inline void gravityKernel(GameState *state,
+                                 const ItemType type,
+                                 const uint begin,
+                                 const uint end) {
+  for (uint i = begin; i < end; i++) {
+    Item *item = &state->world.blocks[state->items.blocks[type][i]].item;
+
+    // In the original, default direction is always right
+    // On the following games, the starting direction of an
+    // item depends on your position in relation to the block
+
+    if (item->velocity.y < MAX_GRAVITY)
+      item->velocity.y += GRAVITY;
+  }
+}
+
+static inline void moveKernel(GameState *state,
+                              const ItemType type,
+                              const uint begin,
+                              const uint end) {
+  for (uint i = begin; i < end; i++) {
+    Item *item = &state->world.blocks[state->items.blocks[type][i]].item;
+    if (!item->visible)
+      continue;
+
+    item->rect.x += item->velocity.x;
+    item->rect.y += item->velocity.y;
+  }
+}
+
+// Finds the hits of a range of items against the level, into the chunk
+// of that range
+static inline void detectKernel(GameState *state,
+                                const ItemType type,
+                                const uint chunk,
+                                const uint begin,
+                                const uint end) {
+  const World *world = &state->world;
+  struct ContactChunk *out = &state->contacts.chunks[chunk];
+  const Num tile = NUM(state->screen.tile);
+  Num toi = 0;
+  int axis;
+
+  out->count = 0;
+  for (uint i = begin; i < end; i++) {
+    const ushort index = state->items.blocks[type][i];
+    const Item *item = &world->blocks[index].item;
+    if (!item->visible)
+      continue;
+
+    for (uint j = 0; j < world->blocksLenght; j++) {
+      if (world->blocks[j].broken)
+        continue;
+
+      axis = collision(
+        item->rect, item->velocity, world->blocks[j].rect, tile / 2, &toi);
+      if (axis)
+        pushContact(out->list,
+                    &out->count,
+                    CHUNK_CONTACTS,
+                    (Contact){BODY_ITEM, TARGET_BLOCK, index, j, axis, toi});
+    }
+    for (uint j = 0; j < world->objsLength; j++) {
+      axis = itemObjectCollision(item, &world->objs[j]);
+      if (axis)
+        pushContact(out->list,
+                    &out->count,
+                    CHUNK_CONTACTS,
+                    (Contact){BODY_ITEM, TARGET_OBJECT, index, j, axis, 0});
+    }
+  }
+}
+
+static inline void resolveContact(GameState *state,
+                                  Item *item,
+                                  const Contact *contact,
+                                  const bool hops) {
+  const Num isize = NUM(state->screen.tile);
+  const Box *target;
+  int result;
+
+  if (contact->target == TARGET_BLOCK) {
+    const Block *const block = &state->world.blocks[contact->targetIndex];
+    if (block->broken)
+      return;
+
+    result =
+      collision(item->rect, item->velocity, block->rect, isize / 2, NULL);
+    if (!result)
+      return;
+
+    if (block->gotHit && block->rect.y > item->rect.y) {
+      item->velocity.y = -ITEM_JUMP_FORCE;
+      return;
+    }
+    target = &block->rect;
+  } else {
+    target = &state->world.objs[contact->targetIndex];
+    result = itemObjectCollision(item, target);
+    if (!result)
+      return;
+  }
+
+  // EROR: On the frame before star hopping starts, the resolve is not
+  // properly made FIX: The idiot here just did not account for a start
+  // hitting the top of a block
+  resolveCollision(&item->rect, target, result);
+
+  if (result > 0)
+    item->velocity.x = -item->velocity.x;
+  else if (hops && item->rect.y + item->rect.h == target->y)
+    item->velocity.y = -ITEM_JUMP_FORCE;
+  else
+    item->velocity.y = 0;
+}
+
+// Each item goes through its own run of the sorted contacts, earliest first
+static inline void resolveKernel(GameState *state,
+                                 const ItemType type,
+                                 const bool hops) {
+  const ItemLists *items = &state->items;
+
+  for (uint i = 0; i < items->count[type]; i++) {
+    const ushort index = items->blocks[type][i];
+    Item *item = &state->world.blocks[index].item;
+    const Contact *run = &state->contacts.list[items->firstContact[index]];
+
+    for (uint c = 0; c < items->contactCount[index]; c++)
+      resolveContact(state, item, &run[c], hops);
+  }
+}
+
+#define X(type, name, powerUp, moves, hops, ...)                               \
+  static void gravity##name(                                                   \
+    void *data, const uint chunk, const uint begin, const uint end) {          \
+    (void)chunk;                                                               \
+    gravityKernel(data, type, begin, end);                                     \
+  }                                                                            \
+  static void move##name(                                                      \
+    void *data, const uint chunk, const uint begin, const uint end) {          \
+    (void)chunk;                                                               \
+    moveKernel(data, type, begin, end);                                        \
+  }                                                                            \
+  static void detect##name(                                                    \
+    void *data, const uint chunk, const uint begin, const uint end) {          \
+    detectKernel(data, type, chunk, begin, end);                               \
+  }                                                                            \
+  static void resolve##name(GameState *state) {                                \
+    resolveKernel(state, type, hops);                                          \
+  }
+ITEM_BEHAVIORS(X)
+#undef X
+
+static const struct {
+  JobFunc gravity, move, detect;
+  void (*resolve)(GameState *state);
+} kernels[ITEM_TYPES] = {
+#define X(type, name, ...)                                                     \
+  [type] = {gravity##name, move##name, detect##name, resolve##name},
+  ITEM_BEHAVIORS(X)
+#undef X
+};
+
+void itemGravity(GameState *state) {
+  for (uint t = 0; t < ITEM_TYPES; t++)
+    if (state->items.count[t])
+      parallelFor(&state->jobs,
+                  state->items.count[t],
+                  MOVE_GRAIN,
+                  kernels[t].gravity,
+                  state);
+}
+
+void moveItems(GameState *state) {
+  for (uint t = 0; t < ITEM_TYPES; t++)
+    if (state->items.count[t])
+      parallelFor(&state->jobs,
+                  state->items.count[t],
+                  MOVE_GRAIN,
+                  kernels[t].move,
+                  state);
+}
+
+// Takes items out of the simulation once they leave the screen
+void cullItems(GameState *state) {
+  const ItemLists *items = &state->items;
+  const Num tile = NUM(state->screen.tile), w = NUM(state->screen.w),
+            h = NUM(state->screen.h);
+
+  for (uint t = 0; t < ITEM_TYPES; t++)
+    for (uint i = 0; i < items->count[t]; i++) {
+      Item *item = &state->world.blocks[items->blocks[t][i]].item;
+
+      if (item->visible &&
+          ((item->rect.x + tile < 0 && item->rect.x > w) &&
+           (item->rect.y > 0 && item->rect.y + tile < h)))
+        item->visible = false;
+    }
+}
+
+// Items, spread over the job threads one type at a time
+void detectItemContacts(GameState *state) {
+  Contacts *contacts = &state->contacts;
+
+  for (uint t = 0; t < ITEM_TYPES; t++) {
+    if (!state->items.count[t])
+      continue;
+
+    const uint chunks = parallelFor(&state->jobs,
+                                    state->items.count[t],
+                                    ITEM_GRAIN,
+                                    kernels[t].detect,
+                                    state);
+    for (uint c = 0; c < chunks; c++) {
+      const struct ContactChunk *chunk = &contacts->chunks[c];
+      for (uint i = 0; i < chunk->count; i++)
+        pushContact(
+          contacts->list, &contacts->count, MAX_CONTACTS, chunk->list[i]);
+    }
+  }
+}
+
+// Call this on the sorted contacts, after the other bodies are resolved.
+// An item only ever touches itself, so going type by type gives the same
+// result as going through the contacts in order.
+void resolveItemContacts(GameState *state) {
+  const Contacts *contacts = &state->contacts;
+  ItemLists *items = &state->items;
+
+  for (uint i = 0; i < contacts->count; i++) {
+    const Contact *contact = &contacts->list[i];
+    if (contact->body != BODY_ITEM)
+      continue;
+
+    if (!items->contactCount[contact->bodyIndex]++)
+      items->firstContact[contact->bodyIndex] = i;
+  }
+
+  for (uint t = 0; t < ITEM_TYPES; t++)
+    if (items->count[t])
+      kernels[t].resolve(state);
+}
+
+// Turns the items around at the edges of the level
+void boundItems(GameState *state) {
+  const ItemLists *items = &state->items;
+  const Num w = NUM(state->screen.w);
+
+  for (uint t = 0; t < ITEM_TYPES; t++)
+    for (uint i = 0; i < items->count[t]; i++) {
+      Item *item = &state->world.blocks[items->blocks[t][i]].item;
+      if (!item->visible)
+        continue;
+
+      if (item->rect.x < 0 || item->rect.x + item->rect.w > w)
+        item->velocity.x *= -1;
+      else if (item->rect.y + item->rect.w > w)
+        item->velocity.y = 0;
+      else if (item->rect.y < 0)
+        item->velocity.y = GRAVITY * 2;
+    }
+}
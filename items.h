@@ -0,0 +1,17 @@
+#ifndef ITEMS_H
+#define ITEMS_H
+
+#include "gameState.h"
+
+extern const ItemBehavior itemBehaviors[ITEM_TYPES];
+
+void partitionItems(GameState *state);
+ushort itemFrame(const Item *item, const uint now);
+void itemGravity(GameState *state);
+void moveItems(GameState *state);
+void cullItems(GameState *state);
+void detectItemContacts(GameState *state);
+void resolveItemContacts(GameState *state);
+void boundItems(GameState *state);
+
+#endif
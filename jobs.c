@@ -0,0 +1,202 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_atomic.h>
+#include <SDL2/SDL_cpuinfo.h>
+#include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_thread.h>
+#include <SDL2/SDL_timer.h>
+#include "colliders.h"
+#include "enemy.h"
+#include "gameState.h"
+#include "jobs.h"
+#include "replay.h"
+
+static bool pushJob(JobQueue *queue, const Job *job) {
+  SDL_AtomicLock(&queue->lock);
+  const bool full = queue->bottom - queue->top >= JOB_QUEUE_SIZE;
+  if (!full)
+    queue->jobs[queue->bottom++ % JOB_QUEUE_SIZE] = *job;
+  SDL_AtomicUnlock(&queue->lock);
+  return !full;
+}
+
+// The newest job, only the owner thread takes from this end
+static bool popJob(JobQueue *queue, Job *job) {
+  SDL_AtomicLock(&queue->lock);
+  const bool empty = queue->bottom == queue->top;
+  if (!empty)
+    *job = queue->jobs[--queue->bottom % JOB_QUEUE_SIZE];
+  SDL_AtomicUnlock(&queue->lock);
+  return !empty;
+}
+
+// The oldest job, taken by threads that ran out of their own
+static bool stealJob(JobQueue *queue, Job *job) {
+  SDL_AtomicLock(&queue->lock);
+  const bool empty = queue->bottom == queue->top;
+  if (!empty)
+    *job = queue->jobs[queue->top++ % JOB_QUEUE_SIZE];
+  SDL_AtomicUnlock(&queue->lock);
+  return !empty;
+}
+
+// Takes a job from the thread own queue, or from the next busy one
+static bool takeJob(Jobs *jobs, const uint index, Job *job) {
+  if (popJob(&jobs->queues[index], job))
+    return true;
+
+  for (uint i = 1; i < jobs->count; i++) {
+    if (stealJob(&jobs->queues[(index + i) % jobs->count], job))
+      return true;
+  }
+  return false;
+}
+
+static void runJob(Jobs *jobs, const Job *job) {
+  job->func(job->data, job->chunk, job->begin, job->end);
+  SDL_AtomicAdd(&jobs->pending, -1);
+}
+
+static int worker(void *data) {
+  struct JobWorker *self = data;
+  Jobs *jobs = self->jobs;
+  Job job;
+
+  while (true) {
+    SDL_SemWait(jobs->wake);
+    if (SDL_AtomicGet(&jobs->quit))
+      return 0;
+
+    while (takeJob(jobs, self->index, &job))
+      runJob(jobs, &job);
+  }
+}
+
+// Starts the worker threads, when they cannot be made the jobs simply run on
+// the calling thread
+// @param threads: Threads to work with, counting the calling one
+void initJobs(Jobs *jobs, uint threads) {
+  jobs->count = 1;
+  SDL_AtomicSet(&jobs->pending, 0);
+  SDL_AtomicSet(&jobs->quit, 0);
+  for (uint i = 0; i < MAX_THREADS; i++) {
+    jobs->queues[i].top = jobs->queues[i].bottom = 0;
+    jobs->queues[i].lock = 0;
+    jobs->workers[i] = (struct JobWorker){jobs, i};
+  }
+
+  if (threads > MAX_THREADS)
+    threads = MAX_THREADS;
+  if (threads <= 1)
+    return;
+
+  jobs->wake = SDL_CreateSemaphore(0);
+  if (!jobs->wake) {
+    printf("Could not create the job semaphore! SDL_Error: %s\n",
+           SDL_GetError());
+    return;
+  }
+
+  for (uint i = 1; i < threads; i++) {
+    jobs->threads[i] = SDL_CreateThread(worker, "worker", &jobs->workers[i]);
+    if (!jobs->threads[i]) {
+      printf("Could not create a job thread! SDL_Error: %s\n", SDL_GetError());
+      break;
+    }
+    jobs->count++;
+  }
+}
+
+// Stops and joins the worker threads
+void freeJobs(Jobs *jobs) {
+  SDL_AtomicSet(&jobs->quit, 1);
+  for (uint i = 1; i < jobs->count; i++)
+    SDL_SemPost(jobs->wake);
+  for (uint i = 1; i < jobs->count; i++) {
+    SDL_WaitThread(jobs->threads[i], NULL);
+    jobs->threads[i] = NULL;
+  }
+  if (jobs->wake)
+    SDL_DestroySemaphore(jobs->wake);
+  jobs->wake = NULL;
+  jobs->count = 1;
+}
+
+// Splits count entities into chunks of grain and runs them on every thread,
+// returning once all of them are done. Chunks only depend on count and grain,
+// so results kept per chunk merge the same way with any number of threads.
+// @return The number of chunks
+uint parallelFor(Jobs *jobs,
+                 const uint count,
+                 const uint grain,
+                 const JobFunc func,
+                 void *data) {
+  const uint chunks = (count + grain - 1) / grain;
+
+  if (jobs->count <= 1 || chunks <= 1) {
+    for (uint i = 0; i < chunks; i++) {
+      const uint end = (i + 1) * grain;
+      func(data, i, i * grain, end < count ? end : count);
+    }
+    return chunks;
+  }
+
+  // Every thread starts with its share, the rest gets stolen
+  SDL_AtomicAdd(&jobs->pending, chunks);
+  for (uint i = 0; i < chunks; i++) {
+    const uint end = (i + 1) * grain;
+    const Job job = {func, data, i, i * grain, end < count ? end : count};
+    if (!pushJob(&jobs->queues[i % jobs->count], &job))
+      runJob(jobs, &job);
+  }
+  for (uint i = 1; i < jobs->count; i++)
+    SDL_SemPost(jobs->wake);
+
+  Job job;
+  while (SDL_AtomicGet(&jobs->pending) > 0) {
+    if (takeJob(jobs, 0, &job))
+      runJob(jobs, &job);
+  }
+  return chunks;
+}
+
+// Updates a crowd of enemies, all of them awake, with 1, 2, 4 and 8 threads
+void benchJobs(GameState *state) {
+  const uint counts[] = {1, 2, 4, 8}, ticks = 600;
+  const double freq = SDL_GetPerformanceFrequency();
+  const ushort tile = state->screen.tile;
+  World *world = &state->world;
+  const uint threads = state->jobs.count;
+
+  // Packed around the player, on a floor as wide as the awake range
+  const Num px = world->players[0].hitbox.x, w = NUM(state->screen.w);
+  const Num floorY = NUM(state->screen.h - tile * 2);
+  world->objsLength = 1;
+  world->objs[0] = (Box){px - w * 2, floorY, w * 4, NUM(tile * 2)};
+  world->enemies.count = 0;
+  for (uint i = 0; i < MAX_ENEMIES; i++) {
+    const Num x = px - w + NUM(1) + (w * 2 - NUM(tile * 2)) / MAX_ENEMIES * i;
+    spawnEnemy(world, GOOMBA, x, floorY - NUM(tile));
+  }
+  const World scene = *world;
+
+  for (uint c = 0; c < sizeof(counts) / sizeof(*counts); c++) {
+    freeJobs(&state->jobs);
+    initJobs(&state->jobs, counts[c]);
+    state->world = scene;
+    updateColliders(state);
+
+    const Uint64 start = SDL_GetPerformanceCounter();
+    for (uint t = 0; t < ticks; t++)
+      updateEnemies(state);
+    const double time = (SDL_GetPerformanceCounter() - start) / freq;
+
+    printf("%u enemies on %u threads: %.3f us per tick, hash %016llx\n",
+           world->enemies.count,
+           state->jobs.count,
+           time * 1e6 / ticks,
+           (unsigned long long)hashWorld(world));
+  }
+
+  freeJobs(&state->jobs);
+  initJobs(&state->jobs, threads);
+}
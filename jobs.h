@@ -0,0 +1,15 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include "gameState.h"
+
+void initJobs(Jobs *jobs, uint threads);
+void freeJobs(Jobs *jobs);
+uint parallelFor(Jobs *jobs,
+                 const uint count,
+                 const uint grain,
+                 const JobFunc func,
+                 void *data);
+void benchJobs(GameState *state);
+
+#endif
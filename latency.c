@@ -0,0 +1,112 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_timer.h>
+#include "gameState.h"
+#include "latency.h"
+
+// How long before the expected present the input is sampled in late mode
+#define LATE_MARGIN 0.0015
+// Weight of a new measure in the moving averages
+#define SMOOTHING 0.1
+
+static double seconds(const Uint64 counter) {
+  return counter / (double)SDL_GetPerformanceFrequency();
+}
+
+// Called with each sampled input
+// @param stamp: When the oldest event behind this input happened
+void markInput(GameState *state, const Input input, const Uint64 stamp) {
+  Latency *latency = &state->latency;
+  if (input != latency->sampled && !latency->changed)
+    latency->changed = stamp;
+  latency->sampled = input;
+}
+
+// Called after a tick, the changed input has now reached the simulation
+void markSimulated(GameState *state) {
+  Latency *latency = &state->latency;
+  if (latency->changed && !latency->simulated)
+    latency->simulated = latency->changed;
+  latency->changed = 0;
+}
+
+// Called right before presenting, to learn how long a frame takes to make
+void markRendered(GameState *state) {
+  Latency *latency = &state->latency;
+  if (!latency->frameStart)
+    return;
+
+  const double cost =
+    seconds(SDL_GetPerformanceCounter() - latency->frameStart);
+  latency->renderCost += (cost - latency->renderCost) * SMOOTHING;
+}
+
+// Called right after presenting, a simulated input change is now on screen
+void markPresented(GameState *state) {
+  Latency *latency = &state->latency;
+  const Uint64 now = SDL_GetPerformanceCounter();
+
+  if (latency->lastPresent) {
+    const double period = seconds(now - latency->lastPresent);
+    latency->framePeriod += (period - latency->framePeriod) * SMOOTHING;
+  }
+  latency->lastPresent = now;
+
+  if (!latency->simulated)
+    return;
+
+  const double elapsed = seconds(now - latency->simulated) * 1000;
+  uint bucket = elapsed / LATENCY_BUCKET_MS;
+  if (bucket > LATENCY_BUCKETS)
+    bucket = LATENCY_BUCKETS;
+
+  latency->histogram[bucket]++;
+  latency->samples++;
+  latency->total += elapsed;
+  if (elapsed > latency->worst)
+    latency->worst = elapsed;
+  latency->simulated = 0;
+}
+
+// In late mode, sleeps until just enough time is left before the next
+// present to sample input, simulate and render
+void waitForLateInput(GameState *state) {
+  Latency *latency = &state->latency;
+
+  if (latency->late && latency->lastPresent && latency->framePeriod > 0) {
+    const double wake = seconds(latency->lastPresent) + latency->framePeriod -
+                        latency->renderCost - LATE_MARGIN;
+    const double left = wake - seconds(SDL_GetPerformanceCounter());
+    if (left >= 0.001)
+      SDL_Delay(left * 1000);
+  }
+  latency->frameStart = SDL_GetPerformanceCounter();
+}
+
+void printLatency(GameState *state) {
+  const Latency *latency = &state->latency;
+  if (!latency->samples)
+    return;
+
+  printf("Input to present latency (%s sampling): %u samples, average %.2f "
+         "ms, worst %.2f ms\n",
+         latency->late ? "late" : "early",
+         latency->samples,
+         latency->total / latency->samples,
+         latency->worst);
+
+  for (uint i = 0; i <= LATENCY_BUCKETS; i++) {
+    if (!latency->histogram[i])
+      continue;
+
+    const double share = latency->histogram[i] * 100.0 / latency->samples;
+    if (i < LATENCY_BUCKETS)
+      printf(
+        "%3u-%3u ms: ", i * LATENCY_BUCKET_MS, (i + 1) * LATENCY_BUCKET_MS);
+    else
+      printf("  >%3u ms: ", i * LATENCY_BUCKET_MS);
+    printf("%6u %5.1f%% ", latency->histogram[i], share);
+    for (uint j = 0; j < share / 2; j++)
+      putchar('#');
+    putchar('\n');
+  }
+}
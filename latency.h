@@ -0,0 +1,13 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "gameState.h"
+
+void markInput(GameState *state, const Input input, const Uint64 stamp);
+void markSimulated(GameState *state);
+void markRendered(GameState *state);
+void markPresented(GameState *state);
+void waitForLateInput(GameState *state);
+void printLatency(GameState *state);
+
+#endif
@@ -0,0 +1,97 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_render.h>
+#include "gameState.h"
+#include "layer.h"
+#include "surface.h"
+
+// Draws the sky and the terrain
+static void drawStatic(GameState *state) {
+  Screen *screen = &state->screen;
+
+  // Not a clear, that would ignore the clip rectangle
+  SDL_SetRenderDrawColor(state->renderer, 92, 148, 252, 255);
+  SDL_RenderFillRect(state->renderer, NULL);
+
+  SDL_SetRenderDrawColor(state->renderer, 255, 0, 0, 255);
+  // NOTES: Delmiter of the bottom of the screen
+  SDL_RenderDrawLine(state->renderer, 0, screen->h, screen->w, screen->h);
+
+  SDL_Rect srcground = {0, 16, 16, 16};
+  const float tile = screen->tile;
+
+  // Rendering ground, a tile at a time
+  // NOTE: This must be behind the block breaking bits
+  for (uint i = 0; i < state->world.objsLength; i++) {
+    const SDL_FRect ground = boxToFRect(state->world.objs[i]);
+    if (ground.x + ground.w < 0 || ground.x > screen->w)
+      continue;
+
+    for (float y = ground.y; y < ground.y + ground.h; y += tile) {
+      for (float x = ground.x; x < ground.x + ground.w; x += tile) {
+        const SDL_FRect dstground = {x, y, tile, tile};
+        SDL_RenderCopyF(
+          state->renderer, state->sheets.objs, &srcground, &dstground);
+      }
+    }
+  }
+}
+
+// Creates the render target of the static layer. When the renderer has no
+// render targets the layer is drawn directly every frame instead.
+void initStaticLayer(GameState *state) {
+  StaticLayer *layer = &state->layer;
+  layer->supported = SDL_RenderTargetSupported(state->renderer);
+
+  if (layer->supported) {
+    layer->texture = SDL_CreateTexture(state->renderer,
+                                       SDL_PIXELFORMAT_RGBA8888,
+                                       SDL_TEXTUREACCESS_TARGET,
+                                       state->screen.w,
+                                       state->screen.h);
+    if (!layer->texture) {
+      printf("Could not cache the static layer! SDL_Error: %s\n",
+             SDL_GetError());
+      layer->supported = false;
+    }
+  }
+  invalidateStaticLayer(state);
+}
+
+// Call this whenever the terrain changes or the render target was lost
+void invalidateStaticLayer(GameState *state) {
+  state->layer.held = false;
+  invalidateSurface(state);
+}
+
+// Draws the static layer with a single copy, redrawing the render target
+// only after it was invalidated. The screen does not scroll yet, so one
+// screen sized target covers everything that can be seen.
+void renderStaticLayer(GameState *state) {
+  StaticLayer *layer = &state->layer;
+  const SDL_FRect screen = {0, 0, state->screen.w, state->screen.h};
+
+  // It only changes when the layer gets invalidated
+  traceSprite(state, &screen, spriteKey(NULL, NULL, 0));
+  if (!layer->supported) {
+    for (uint cursor = 0; clipSprite(state, &screen, &cursor);)
+      drawStatic(state);
+    return;
+  }
+
+  if (!layer->held) {
+    SDL_Texture *target = SDL_GetRenderTarget(state->renderer);
+    SDL_SetRenderTarget(state->renderer, layer->texture);
+    drawStatic(state);
+    SDL_SetRenderTarget(state->renderer, target);
+    layer->held = true;
+  }
+
+  for (uint cursor = 0; clipSprite(state, &screen, &cursor);)
+    SDL_RenderCopy(state->renderer, layer->texture, NULL, NULL);
+}
+
+void freeStaticLayer(GameState *state) {
+  if (state->layer.texture)
+    SDL_DestroyTexture(state->layer.texture);
+  state->layer.texture = NULL;
+}
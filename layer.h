@@ -0,0 +1,11 @@
+#ifndef LAYER_H
+#define LAYER_H
+
+#include "gameState.h"
+
+void initStaticLayer(GameState *state);
+void invalidateStaticLayer(GameState *state);
+void renderStaticLayer(GameState *state);
+void freeStaticLayer(GameState *state);
+
+#endif
@@ -0,0 +1,217 @@
+#include <SDL2/SDL.h>
+#include "enemy.h"
+#include "gameState.h"
+#include "layer.h"
+#include "level.h"
+#include "memory.h"
+#include "timeline.h"
+
+// TODO: Add an interrogation block with a single coin
+// Create a block in state.blocks
+void createBlock(GameState *state,
+                 const int x,
+                 const int y,
+                 const BlockState tBlock,
+                 const ItemType tItem) {
+  BlockSprite sprite = INTERROGATION_SPRITE;
+  if (tBlock == NOTHING || tItem == COINS)
+    sprite = BRICK_SPRITE;
+
+  const Num tile = NUM(state->screen.tile), bx = NUM(x), by = NUM(y);
+  Num iw = tile;
+  if (tItem == COINS)
+    iw /= 2;
+
+  Block *block = &state->world.blocks[state->world.blocksLenght];
+  *block = (Block) {
+    .rect = (Box) {bx, by, tile, tile},
+    .initY = by,
+    .gotHit = false,
+    .broken = false,
+    .type = tBlock,
+    .sprite = sprite,
+  };
+  state->world.blocksLenght++;
+
+  if (tBlock == NOTHING) {
+    block->item = (Item) {{0, 0, 0, 0}, {0, 0}, false, false, false, 0};
+    const Num size = tile / 2;
+
+    for (ushort i = 0; i < MAX_BLOCK_PARTICLES; i++) {
+      struct Particle *particle = &block->particles[i];
+
+      // Defining the particles X values by column
+      if (i % 2 == 0) {
+        particle->rect.x = bx;
+        particle->velocity.x = -MAX_SPEED / 2;
+      } else {
+        particle->rect.x = bx + size;
+        particle->velocity.x = MAX_SPEED / 2;
+      }
+
+      // Defining the particles Y values by row
+      if (i < 2) {
+        particle->rect.y = by;
+        particle->velocity.y = NUM_MUL(MAX_JUMP, NUM(1.15f));
+      } else {
+        particle->rect.y = by + size;
+        particle->velocity.y = MAX_JUMP;
+      }
+
+      particle->rect.w = size;
+      particle->rect.h = size;
+    }
+
+    return;
+  } else if (tItem == COINS) {
+    block->maxCoins = MAX_BLOCK_COINS;
+    block->coinCount = block->maxCoins;
+
+    for (ushort i = 0; i < block->maxCoins; i++) {
+      block->coins[i] = (Coin) {
+        .rect = {bx + iw / 2, by, iw, tile},
+        .onAir = false,
+        .willFall = false,
+      };
+    }
+  }
+
+  block->item = (Item) {
+    .velocity = {ITEM_SPEED, 0},
+    .rect = {bx, by, iw, tile},
+    .type = tItem,
+    .free = false,
+    .visible = true,
+  };
+}
+
+// How many of each kind of tile a level file holds, they may not all fit
+typedef struct {
+  uint blocks, objs, enemies;
+} TileCount;
+
+// Places whatever a level character stands for at a tile
+// @param count: Counts the tile, even when the world has no room left for it
+// @return false when the character is not part of the level format
+static bool placeTile(GameState *state,
+                      const char c,
+                      const uint col,
+                      const uint row,
+                      TileCount *count) {
+  World *world = &state->world;
+  const ushort tile = state->screen.tile;
+  const int x = col * tile, y = row * tile;
+
+  switch (c) {
+    case '.':
+    case ' ':
+      return true;
+    case 'G':
+      count->objs++;
+      if (world->objsLength < MAX_OBJS)
+        world->objs[world->objsLength++] =
+          (Box){NUM(x), NUM(y), NUM(tile), NUM(tile)};
+      return true;
+    case 'g':
+    case 'k': {
+      const EnemyType type = c == 'k' ? KOOPA : GOOMBA;
+      const Num h = type == KOOPA ? NUM(tile + tile / 2) : NUM(tile);
+      count->enemies++;
+      spawnEnemy(world, type, NUM(x), NUM(y + tile) - h);
+      return true;
+    }
+  }
+
+  // Bricks hold nothing, their item is never used
+  BlockState type = FULL;
+  ItemType item = COINS;
+  if (c == 'B')
+    type = NOTHING;
+  else if (c == '?')
+    item = COINS;
+  else if (c == 'M')
+    item = MUSHROOM;
+  else if (c == 'F')
+    item = FIRE_FLOWER;
+  else if (c == 'S')
+    item = STAR;
+  else
+    return false;
+
+  count->blocks++;
+  if (world->blocksLenght < MAX_BLOCKS)
+    createBlock(state, x, y, type, item);
+  return true;
+}
+
+// Reads a level file into the world, keeping the player as it is. The
+// format is described at the top of assets/levels/1-1.txt.
+// @param path: The level file
+// @return false if it could not be read, the world is left untouched then
+bool loadLevel(GameState *state, const char *path) {
+  World *world = &state->world;
+  SDL_RWops *file = SDL_RWFromFile(path, "rb");
+  if (!file) {
+    printf(
+      "Could not load the level %s! SDL_Error: %s\n", path, SDL_GetError());
+    return false;
+  }
+
+  // The text stays in the level arena until the next level replaces it
+  resetLevelMemory(state);
+  const Sint64 length = SDL_RWsize(file);
+  const size_t size = length > 0 ? length : 0;
+  char *data = arenaAlloc(&state->memory.level, size);
+  if (!data || length < 0 || SDL_RWread(file, data, 1, size) != size) {
+    printf("Could not load the level %s, it is too big or unreadable! "
+           "SDL_Error: %s\n",
+           path,
+           SDL_GetError());
+    SDL_RWclose(file);
+    return false;
+  }
+  SDL_RWclose(file);
+
+  world->blocksLenght = 0;
+  world->objsLength = 0;
+  world->enemies.count = 0;
+  // They would go on animating the blocks of the new level
+  stopSequences(world, SEQUENCE_BUMP);
+  stopSequences(world, SEQUENCE_COIN);
+
+  TileCount count = {0};
+  uint col = 0, row = 0;
+  for (size_t i = 0; i < size; i++) {
+    const char c = data[i];
+
+    if (c == '\n') {
+      row++;
+      col = 0;
+    } else if (c == ';' && col == 0) {
+      // Comments take the whole line and are not a row
+      while (i + 1 < size && data[i + 1] != '\n')
+        i++;
+      i++;
+    } else if (c != '\r') {
+      if (!placeTile(state, c, col, row, &count))
+        printf("Unknown tile '%c' at %u, %u in %s\n", c, col, row, path);
+      col++;
+    }
+  }
+
+  if (count.blocks > world->blocksLenght || count.objs > world->objsLength ||
+      count.enemies > world->enemies.count)
+    printf("The level %s does not fit, left out %u of %u blocks, %u of %u "
+           "ground tiles and %u of %u enemies\n",
+           path,
+           count.blocks - world->blocksLenght,
+           count.blocks,
+           count.objs - world->objsLength,
+           count.objs,
+           count.enemies - world->enemies.count,
+           count.enemies);
+
+  // The cached ground is from the old level
+  invalidateStaticLayer(state);
+  return true;
+}
@@ -0,0 +1,13 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include "gameState.h"
+
+void createBlock(GameState *state,
+                 const int x,
+                 const int y,
+                 const BlockState tBlock,
+                 const ItemType tItem);
+bool loadLevel(GameState *state, const char *path);
+
+#endif
@@ -2,87 +2,196 @@
 #include <SDL2/SDL_keyboard.h>
 #include <SDL2/SDL_rect.h>
 #include <stdbool.h>
-#include "collision.h"
+#include <stdlib.h>
+#include <string.h>
+#include "assets.h"
+#include "broadphase.h"
+#include "capture.h"
+#include "enemy.h"
 #include "gameState.h"
+#include "history.h"
+#include "idle.h"
 #include "init.h"
+#include "jobs.h"
+#include "latency.h"
+#include "level.h"
+#include "memory.h"
+#include "net.h"
 #include "input.h"
+#include "physics.h"
 #include "render.h"
+#include "replay.h"
+#include "scheduler.h"
+#include "snapshot.h"
+#include "sound.h"
+#include "speed.h"
+#include "utils.h"
+#include "watch.h"
 
-// Apply physics to the player, the objects, and the enemies
-void physics(GameState *state) {
-  Player *player = &state->player;
-  float dt = state->screen.deltaTime;
-  const ushort TARGET_FPS = state->screen.targetFps;
+// The most ticks simulated to catch up in a single frame
+#define MAX_CATCH_UP 5
 
-  // Resolve player hitbox
-  if (player->crounching && player->hitbox.h == state->screen.tile * 2) {
-    player->hitbox.y += state->screen.tile;
-    player->hitbox.h = state->screen.tile;
-  } else if (!player->crounching && player->tall &&
-             player->hitbox.h != state->screen.tile * 2) {
-    player->hitbox.y -= state->screen.tile;
-    player->hitbox.h = state->screen.tile * 2;
-  }
-
-  // Player collision
-  if (player->velocity.y < MAX_GRAVITY)
-    player->velocity.y += GRAVITY;
-  playerCollision(state);
-  player->hitbox.x += player->velocity.x * TARGET_FPS * dt;
-  player->hitbox.y += player->velocity.y * TARGET_FPS * dt;
+// Shows a recorded history, holding R plays it backwards
+void playHistory(GameState *state, const char *path) {
+  HistoryReader reader;
+  if (!openHistoryReader(&reader, path))
+    quit(state, 1);
 
-  // Resolve player rectangle
-  player->rect.y = player->crounching ? player->hitbox.y - state->screen.tile
-                                      : player->hitbox.y;
-  player->rect.x = player->hitbox.x;
-  player->rect.x -= state->screen.tile / 4.0;
+  uint index = 0;
+  while (seekHistory(&reader, index, &state->world)) {
+    handleEvents(state);
+    render(state);
 
-  // Fireballs collision
-  for (ushort i = 0; i < MAX_FIREBALLS; i++) {
-    Fireball *ball = &player->fireballs[i];
-    if (!ball->visible)
+    if (!assetsLoaded(state))
       continue;
-
-    fireballCollision(state, i);
-    ball->rect.x += ball->velocity.x * TARGET_FPS * dt;
-    ball->rect.y += ball->velocity.y * TARGET_FPS * dt;
+    if (!state->snapshots.rewinding)
+      index++;
+    else if (index)
+      index--;
   }
+  closeHistoryReader(&reader);
+}
 
-  // Items collision
-  for (uint i = 0; i < state->blocksLenght; i++) {
-    Block *block = &state->blocks[i];
-    Item *item = &state->blocks[i].item;
-
-    if ((!item->free || !item->visible) || item->type == FIRE_FLOWER ||
-        block->type != EMPTY)
-      continue;
+// Advances the world by one tick, or takes it one tick back in time
+// @return false when the tick waits for the input of the other player
+bool step(GameState *state, const Input input) {
+  if (state->snapshots.rewinding) {
+    if (rewindSnapshot(state, 1))
+      writeHistory(&state->history, &state->world);
+    return true;
+  }
 
-    // In the original, default direction is always right
-    // On the following games, the starting direction of an
-    // item depends on your position in relation to the block
+  Input inputs[MAX_PLAYERS] = {input};
+  if (state->net.enabled && !lockstepInputs(state, input, inputs))
+    return false;
 
-    if (item->velocity.y < MAX_GRAVITY)
-      item->velocity.y += GRAVITY;
-    itemCollision(state, i);
-    item->rect.x += item->velocity.x * TARGET_FPS * dt;
-    item->rect.y += item->velocity.y * TARGET_FPS * dt;
-  };
+  recordInput(&state->replay, state->world.tick, input);
+  tickPlayers(state, inputs);
+  recordNetCheck(state);
+  markSimulated(state);
+  saveSnapshot(state);
+  writeHistory(&state->history, &state->world);
+  return true;
 }
 
-int main(void) {
-  GameState state;
+int main(int argc, char *argv[]) {
+  // Far too big for the stack of the main thread on some systems
+  static GameState state;
+  double budget = 1000.0 / TICK_RATE;
+  // The renderer is picked when the game starts, before the other options
+  for (int i = 1; i < argc; i++)
+    if (!strcmp(argv[i], "--surface"))
+      state.surface.enabled = true;
   initGame(&state);
-  uint currentTime = SDL_GetTicks(), lastTime;
+  initSpeed(&state);
+  initNet(&state);
+  initWindowState(&state);
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--bench")) {
+      benchSnapshots(&state);
+      benchBroadphase(&state);
+      benchJobs(&state);
+      quit(&state, 0);
+    } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+      freeJobs(&state.jobs);
+      initJobs(&state.jobs, atoi(argv[++i]));
+    } else if (!strcmp(argv[i], "--level") && i + 1 < argc) {
+      free(state.level);
+      state.level = catpath(&state, argv[++i], "");
+      freeWatcher(&state);
+      initWatcher(&state);
+      if (!loadLevel(&state, state.level))
+        quit(&state, 1);
+    } else if (!strcmp(argv[i], "--stress") && i + 1 < argc) {
+      stressEnemies(&state, atoi(argv[++i]));
+      quit(&state, 0);
+    } else if (!strcmp(argv[i], "--history") && i + 1 < argc) {
+      if (!openHistoryWriter(&state.history, argv[++i]))
+        quit(&state, 1);
+    } else if (!strcmp(argv[i], "--play-history") && i + 1 < argc) {
+      playHistory(&state, argv[++i]);
+      quit(&state, 0);
+    } else if (!strcmp(argv[i], "--late-input")) {
+      state.latency.late = true;
+    } else if (!strcmp(argv[i], "--fast-forward") && i + 1 < argc) {
+      setFastForward(&state, argv[++i]);
+    } else if (!strcmp(argv[i], "--host") && i + 1 < argc) {
+      hostNet(&state, argv[++i]);
+    } else if (!strcmp(argv[i], "--join") && i + 1 < argc) {
+      joinNet(&state, argv[++i]);
+    } else if (!strcmp(argv[i], "--input-delay") && i + 1 < argc) {
+      setInputDelay(&state, argv[++i]);
+    } else if (!strcmp(argv[i], "--net-loss") && i + 1 < argc) {
+      simulateNetConditions(&state, argv[++i], NULL);
+    } else if (!strcmp(argv[i], "--net-jitter") && i + 1 < argc) {
+      simulateNetConditions(&state, NULL, argv[++i]);
+    } else if (!strcmp(argv[i], "--budget") && i + 1 < argc) {
+      budget = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--surface")) {
+      // Already taken care of
+    } else if (!strcmp(argv[i], "--no-alloc")) {
+      state.memory.strict = true;
+    } else if (!strcmp(argv[i], "--capture") && i + 1 < argc) {
+      startCapture(&state, argv[++i]);
+    } else if (!strcmp(argv[i], "--record") && i + 1 < argc) {
+      if (!openReplay(&state.replay, argv[++i]))
+        quit(&state, 1);
+    } else if (!strcmp(argv[i], "--replay") && i + 1 < argc) {
+      runReplay(&state, argv[++i]);
+      quit(&state, 0);
+    } else {
+      printf("Unknown option: %s\n", argv[i]);
+      quit(&state, 1);
+    }
+  }
+
+  // Only the game itself makes noise, not the replays and benchmarks
+  initSound(&state);
+  initScheduler(&state, budget);
+  startNet(&state);
+  initIdle(&state);
+
+  // Measured in thousandths of a tick, so the fixed step needs no floats
+  uint currentTime = SDL_GetTicks(), lastTime, accumulator = 0;
+  writeHistory(&state.history, &state.world);
 
   while (true) {
+    // Nothing runs while the window is away, and the time away is skipped
+    if (waitWhileIdle(&state)) {
+      currentTime = SDL_GetTicks();
+      accumulator = 0;
+    }
+    waitForLateInput(&state);
+    beginFrame(&state);
+    checkFrameMemory(&state);
     lastTime = currentTime;
     currentTime = SDL_GetTicks();
     state.screen.deltaTime = (currentTime - lastTime) / 1000.0f;
+    const uint multiplier = tickMultiplier(&state);
+    accumulator += (currentTime - lastTime) * TICK_RATE * multiplier;
+    // Do not try to catch up after a long stall
+    if (accumulator > MAX_CATCH_UP * 1000 * multiplier)
+      accumulator = MAX_CATCH_UP * 1000 * multiplier;
 
-    if (!state.player.transforming) {
-      handleEvents(&state);
-      physics(&state);
+    const Input input = handleEvents(&state);
+    pollWatcher(&state);
+    receiveNet(&state);
+    uint ticks = 0;
+    // Nothing moves until the sprites are in
+    if (!assetsLoaded(&state))
+      accumulator = 0;
+    else if (!multiplier) {
+      // As many ticks as fit in the frame, but always one
+      do {
+        step(&state, input);
+        ticks++;
+      } while (simulationTimeLeft(&state));
     }
+    for (; accumulator >= 1000 && step(&state, input); ticks++)
+      accumulator -= 1000;
+    sendNet(&state);
+    countTicks(&state, ticks);
     render(&state);
   }
 }
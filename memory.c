@@ -0,0 +1,170 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_atomic.h>
+#include <stdlib.h>
+#include "assets.h"
+#include "gameState.h"
+#include "memory.h"
+#include "utils.h"
+
+// Stored before every block SDL allocates, keeps the alignment of malloc
+#define HEADER 16
+// Of everything handed out by an arena
+#define ARENA_ALIGN 16
+
+static SDL_malloc_func realMalloc;
+static SDL_calloc_func realCalloc;
+static SDL_realloc_func realRealloc;
+static SDL_free_func realFree;
+
+// SDL allocates from its own threads too
+static SDL_atomic_t allocations, live, peak;
+
+static void addLive(const int bytes) {
+  const int now = SDL_AtomicAdd(&live, bytes) + bytes;
+  int old;
+  while (now > (old = SDL_AtomicGet(&peak)) && !SDL_AtomicCAS(&peak, old, now))
+    ;
+}
+
+// Writes the size in front of a new block
+// @return The part of the block given to SDL
+static void *track(Uint8 *block, const size_t size) {
+  if (!block)
+    return NULL;
+  *(size_t *)block = size;
+  SDL_AtomicAdd(&allocations, 1);
+  addLive(size);
+  return block + HEADER;
+}
+
+static void *countedMalloc(size_t size) {
+  return track(realMalloc(size + HEADER), size);
+}
+
+static void *countedCalloc(size_t count, size_t size) {
+  if (size && count > ((size_t)-1 - HEADER) / size)
+    return NULL;
+  return track(realCalloc(1, count * size + HEADER), count * size);
+}
+
+static void *countedRealloc(void *memory, size_t size) {
+  if (!memory)
+    return countedMalloc(size);
+
+  Uint8 *block = (Uint8 *)memory - HEADER;
+  const size_t old = *(size_t *)block;
+  block = realRealloc(block, size + HEADER);
+  if (!block)
+    return NULL;
+  addLive(-(int)old);
+  return track(block, size);
+}
+
+static void countedFree(void *memory) {
+  if (!memory)
+    return;
+  Uint8 *block = (Uint8 *)memory - HEADER;
+  addLive(-(int)*(size_t *)block);
+  realFree(block);
+}
+
+// Counts every allocation SDL makes from now on. Call it before SDL_Init(),
+// blocks allocated before it would be freed through the wrong function.
+void countAllocations(void) {
+  SDL_GetMemoryFunctions(&realMalloc, &realCalloc, &realRealloc, &realFree);
+  if (SDL_SetMemoryFunctions(
+        countedMalloc, countedCalloc, countedRealloc, countedFree))
+    printf("Could not count the allocations! SDL_Error: %s\n",
+           SDL_GetError());
+}
+
+static void initArena(GameState *state, Arena *arena, const size_t size) {
+  arena->base = malloc(size);
+  if (!arena->base) {
+    printf("Could not allocate memory for the arenas\n");
+    quit(state, 1);
+  }
+  arena->size = size;
+  arena->used = arena->peak = 0;
+}
+
+void initArenas(GameState *state) {
+  initArena(state, &state->memory.level, LEVEL_ARENA_SIZE);
+  initArena(state, &state->memory.scratch, SCRATCH_ARENA_SIZE);
+}
+
+// @return size bytes that live until the arena is reset, or NULL if it is
+// full
+void *arenaAlloc(Arena *arena, const size_t size) {
+  const size_t start = (arena->used + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+  if (start > arena->size || size > arena->size - start)
+    return NULL;
+
+  arena->used = start + size;
+  if (arena->used > arena->peak)
+    arena->peak = arena->used;
+  return arena->base + start;
+}
+
+void resetArena(Arena *arena) {
+  arena->used = 0;
+}
+
+// Frees everything of the last level and starts measuring the peak of the
+// next one
+void resetLevelMemory(GameState *state) {
+  resetArena(&state->memory.level);
+  state->memory.level.peak = 0;
+  SDL_AtomicSet(&peak, SDL_AtomicGet(&live));
+}
+
+// Ends the last frame, checking if it touched the heap, and starts the next
+// one with an empty scratch arena
+void checkFrameMemory(GameState *state) {
+  Memory *memory = &state->memory;
+  const uint total = SDL_AtomicGet(&allocations),
+             made = total - memory->allocations;
+  memory->allocations = total;
+  resetArena(&memory->scratch);
+
+  // Loading and the first frames allocate on purpose
+  if (!assetsLoaded(state) || state->world.tick < MEMORY_WARMUP_TICKS)
+    return;
+
+  memory->frames++;
+  if (!made)
+    return;
+  memory->allocatingFrames++;
+  if (made > memory->worstFrame)
+    memory->worstFrame = made;
+
+  if (memory->strict) {
+    printf("Tick %u made %u heap allocations\n", state->world.tick, made);
+    quit(state, 1);
+  }
+}
+
+void printMemory(GameState *state) {
+  const Memory *memory = &state->memory;
+  // Only the game itself, not the replays and benchmarks
+  if (!memory->frames)
+    return;
+
+  printf("Level %s: peak heap of SDL %.1f KiB, level arena %zu of %zu "
+         "bytes, scratch arena peak %zu bytes\n",
+         state->level,
+         SDL_AtomicGet(&peak) / 1024.0,
+         memory->level.peak,
+         memory->level.size,
+         memory->scratch.peak);
+  printf("Frames that allocated: %u of %u, at most %u allocations\n",
+         memory->allocatingFrames,
+         memory->frames,
+         memory->worstFrame);
+}
+
+void freeArenas(GameState *state) {
+  free(state->memory.level.base);
+  free(state->memory.scratch.base);
+  state->memory.level = state->memory.scratch = (Arena){0};
+}
@@ -0,0 +1,15 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include "gameState.h"
+
+void countAllocations(void);
+void initArenas(GameState *state);
+void *arenaAlloc(Arena *arena, const size_t size);
+void resetArena(Arena *arena);
+void resetLevelMemory(GameState *state);
+void checkFrameMemory(GameState *state);
+void printMemory(GameState *state);
+void freeArenas(GameState *state);
+
+#endif
@@ -0,0 +1,454 @@
+#include <SDL2/SDL.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gameState.h"
+#include "hud.h"
+#include "init.h"
+#include "net.h"
+#include "replay.h"
+#include "utils.h"
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// A packet starts with the magic, the input delay, the first tick of its
+// inputs, the ticks of input received, a time stamp, the last stamp
+// received and how long ago, the latest world check, the input count, and
+// then one byte of input per tick. Everything is little endian.
+#define NET_MAGIC 0x4D
+// The echo field when there is nothing to echo yet
+#define NO_ECHO 0xFFFF
+// Without a packet from the other side for this long, the game is over
+#define NET_TIMEOUT 10000
+
+static void put16(Uint8 *data, const Uint16 value) {
+  data[0] = value;
+  data[1] = value >> 8;
+}
+
+static void put32(Uint8 *data, const Uint32 value) {
+  put16(data, value);
+  put16(data + 2, value >> 16);
+}
+
+static Uint16 get16(const Uint8 *data) {
+  return data[0] | data[1] << 8;
+}
+
+static Uint32 get32(const Uint8 *data) {
+  return get16(data) | (Uint32)get16(data + 2) << 16;
+}
+
+// Xorshift, only for the simulated conditions
+static Uint32 netRandom(Net *net) {
+  net->seed ^= net->seed << 13;
+  net->seed ^= net->seed >> 17;
+  net->seed ^= net->seed << 5;
+  return net->seed;
+}
+
+// Opens a non blocking UDP socket on a port, 0 for any
+static void openSocket(GameState *state, const Uint16 port) {
+#ifndef _WIN32
+  Net *net = &state->net;
+  net->socket = socket(AF_INET, SOCK_DGRAM, 0);
+  if (net->socket < 0) {
+    printf("Could not open a socket\n");
+    quit(state, 1);
+  }
+  net->enabled = true;
+
+  struct sockaddr_in address = {.sin_family = AF_INET,
+                                .sin_addr.s_addr = htonl(INADDR_ANY),
+                                .sin_port = htons(port)};
+  if (bind(net->socket, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+      fcntl(net->socket, F_SETFL, O_NONBLOCK) < 0) {
+    printf("Could not listen on port %u\n", port);
+    quit(state, 1);
+  }
+#else
+  (void)port;
+  printf("Playing over the network is not supported on this system\n");
+  quit(state, 1);
+#endif
+}
+
+void initNet(GameState *state) {
+  state->net = (Net){.socket = -1, .delay = DEFAULT_INPUT_DELAY};
+}
+
+// Waits for the other player on a port, this side plays the first player
+void hostNet(GameState *state, const char *port) {
+  const int value = atoi(port);
+  if (value <= 0 || value > 65535) {
+    printf("Invalid port: %s\n", port);
+    quit(state, 1);
+  }
+  openSocket(state, value);
+  state->net.host = true;
+  state->net.local = 0;
+}
+
+// Joins a game hosted elsewhere, this side plays the second player
+// @param address: An IPv4 address and a port, like 127.0.0.1:7000
+void joinNet(GameState *state, const char *address) {
+#ifndef _WIN32
+  Net *net = &state->net;
+  char host[64];
+  const char *colon = strrchr(address, ':');
+  struct in_addr parsed;
+
+  if (!colon || colon - address >= (long)sizeof(host) || atoi(colon + 1) <= 0 ||
+      atoi(colon + 1) > 65535) {
+    printf("Join an address with a port, like 127.0.0.1:7000\n");
+    quit(state, 1);
+  }
+  memcpy(host, address, colon - address);
+  host[colon - address] = '\0';
+  if (!inet_aton(host, &parsed)) {
+    printf("Invalid address: %s\n", host);
+    quit(state, 1);
+  }
+
+  openSocket(state, 0);
+  net->peerAddress = parsed.s_addr;
+  net->peerPort = htons(atoi(colon + 1));
+  net->local = 1;
+#else
+  (void)address;
+  openSocket(state, 0);
+#endif
+}
+
+// @param ticks: From 0 to MAX_INPUT_DELAY, both sides must use the same
+void setInputDelay(GameState *state, const char *ticks) {
+  const int value = atoi(ticks);
+  if (value < 0 || value > MAX_INPUT_DELAY || (!value && strcmp(ticks, "0"))) {
+    printf("The input delay goes from 0 to %d ticks\n", MAX_INPUT_DELAY);
+    quit(state, 1);
+  }
+  state->net.delay = value;
+}
+
+// Drops a share of the packets sent and holds the others back by a random
+// time, to try the netcode on a perfect local connection
+// @param loss: In percent
+// @param jitter: The most a packet is held back, in milliseconds
+void simulateNetConditions(GameState *state,
+                           const char *loss,
+                           const char *jitter) {
+  Net *net = &state->net;
+  if (loss) {
+    const int value = atoi(loss);
+    if (value < 0 || value > 100) {
+      printf("The packet loss goes from 0 to 100 percent\n");
+      quit(state, 1);
+    }
+    net->loss = value;
+  }
+  if (jitter) {
+    const int value = atoi(jitter);
+    if (value < 0 || value > 1000) {
+      printf("The jitter goes from 0 to 1000 ms\n");
+      quit(state, 1);
+    }
+    net->jitter = value;
+  }
+}
+
+// Call this once every option is read. The second player joins the world,
+// and the first delay ticks of both players are filled with no input.
+void startNet(GameState *state) {
+  Net *net = &state->net;
+  if (!net->enabled)
+    return;
+
+  if (state->replay.file) {
+    printf("Replays only hold one player, they can not be recorded over the "
+           "network\n");
+    quit(state, 1);
+  }
+  if (!addPlayer(state)) {
+    printf("There is no room for another player\n");
+    quit(state, 1);
+  }
+  state->speed.fastForward = false;
+  initNetHud(state);
+
+  for (uint i = 0; i < MAX_PLAYERS; i++)
+    net->known[i] = net->delay;
+  net->acked = net->delay;
+  net->echo = NO_ECHO;
+  net->seed = SDL_GetPerformanceCounter() | 1;
+  net->start = net->measureStart = net->lastReceived = SDL_GetTicks();
+  if (net->host)
+    printf("Waiting for the other player\n");
+}
+
+static void sendPacket(GameState *state, const Uint8 *data, const uint size) {
+#ifndef _WIN32
+  const Net *net = &state->net;
+  const struct sockaddr_in address = {.sin_family = AF_INET,
+                                      .sin_addr.s_addr = net->peerAddress,
+                                      .sin_port = net->peerPort};
+  sendto(net->socket,
+         data,
+         size,
+         0,
+         (const struct sockaddr *)&address,
+         sizeof(address));
+#else
+  (void)state;
+  (void)data;
+  (void)size;
+#endif
+}
+
+// Sends a packet, unless the simulated connection loses it or holds it back
+static void queuePacket(GameState *state, const Uint8 *data, const uint size) {
+  Net *net = &state->net;
+  net->sent++;
+  net->bytes += size;
+  net->totalBytes += size;
+
+  if (net->loss && netRandom(net) % 100 < net->loss) {
+    net->dropped++;
+    return;
+  }
+  if (!net->jitter || net->queued == NET_QUEUE) {
+    sendPacket(state, data, size);
+    return;
+  }
+
+  struct NetPacket *packet = &net->queue[net->queued++];
+  packet->due = SDL_GetTicks() + netRandom(net) % (net->jitter + 1);
+  packet->size = size;
+  memcpy(packet->data, data, size);
+}
+
+// Sends the held back packets whose time came, in whatever order that is
+static void flushQueue(GameState *state) {
+  Net *net = &state->net;
+  const Uint32 now = SDL_GetTicks();
+
+  for (uint i = 0; i < net->queued;) {
+    struct NetPacket *packet = &net->queue[i];
+    if ((Sint32)(now - packet->due) < 0) {
+      i++;
+      continue;
+    }
+    sendPacket(state, packet->data, packet->size);
+    *packet = net->queue[--net->queued];
+  }
+}
+
+// Compares a world hash of the other side with the one of the same tick
+static void checkWorld(Net *net, const Uint32 tick, const Uint32 hash) {
+  const struct NetCheck *check = &net->checks[tick / TICK_RATE % NET_CHECKS];
+  if (!tick || net->desynced || check->tick != tick)
+    return;
+
+  if (check->hash != hash) {
+    printf("The players went out of sync at tick %u\n", tick);
+    net->desynced = true;
+  }
+}
+
+static void readPacket(GameState *state, const Uint8 *data, const uint size) {
+  Net *net = &state->net;
+  const uint remote = !net->local, tick = state->world.tick;
+  const Uint32 now = SDL_GetTicks();
+
+  if (size < NET_HEADER || data[0] != NET_MAGIC ||
+      size - NET_HEADER < data[24])
+    return;
+  if (data[1] != net->delay) {
+    printf("The other player has an input delay of %u ticks, this one %u\n",
+           data[1],
+           net->delay);
+    quit(state, 1);
+  }
+
+  // Anything already known is just skipped
+  const Uint32 first = get32(data + 2);
+  for (uint i = 0; i < data[24]; i++) {
+    const uint t = first + i;
+    if (t != net->known[remote] || t >= tick + NET_INPUTS)
+      continue;
+    net->inputs[remote][t % NET_INPUTS] = data[NET_HEADER + i];
+    net->known[remote]++;
+  }
+
+  const Uint32 ack = get32(data + 6);
+  if (ack > net->acked && ack <= net->known[net->local])
+    net->acked = ack;
+
+  // The time it sat on the other side does not count
+  const Uint16 echo = get16(data + 12), hold = get16(data + 14);
+  if (hold != NO_ECHO) {
+    const float rtt = (Uint16)((Uint16)now - echo - hold);
+    if (!net->rtt)
+      net->rtt = rtt;
+    net->rttJitter += (fabsf(rtt - net->rtt) - net->rttJitter) / 16;
+    net->rtt += (rtt - net->rtt) / 8;
+  }
+  net->echo = get16(data + 10);
+  net->echoReceived = now;
+  net->lastReceived = now;
+
+  checkWorld(net, get32(data + 16), get32(data + 20));
+}
+
+// Takes in every packet that arrived, call it once a frame before the ticks
+void receiveNet(GameState *state) {
+#ifndef _WIN32
+  Net *net = &state->net;
+  if (!net->enabled)
+    return;
+
+  flushQueue(state);
+
+  Uint8 data[NET_PACKET_SIZE];
+  struct sockaddr_in from;
+  socklen_t length = sizeof(from);
+  ssize_t size;
+  while ((size = recvfrom(net->socket,
+                          data,
+                          sizeof(data),
+                          0,
+                          (struct sockaddr *)&from,
+                          &length)) >= 0) {
+    length = sizeof(from);
+    // The host takes whoever talks first as the other player
+    if (!net->connected && net->host) {
+      net->peerAddress = from.sin_addr.s_addr;
+      net->peerPort = from.sin_port;
+    }
+    if (from.sin_addr.s_addr != net->peerAddress ||
+        from.sin_port != net->peerPort)
+      continue;
+
+    if (!net->connected)
+      printf("The other player is in\n");
+    net->connected = true;
+    net->received++;
+    net->bytes += size;
+    net->totalBytes += size;
+    readPacket(state, data, size);
+  }
+
+  if (net->connected && SDL_GetTicks() - net->lastReceived > NET_TIMEOUT) {
+    printf("Lost the other player\n");
+    quit(state, 1);
+  }
+#else
+  (void)state;
+#endif
+}
+
+// Schedules the local input delay ticks ahead, then gives the input of every
+// player for the next tick
+// @return false while the input of the other player for it is not in
+bool lockstepInputs(GameState *state,
+                    const Input input,
+                    Input inputs[MAX_PLAYERS]) {
+  Net *net = &state->net;
+  const uint tick = state->world.tick;
+  uint *known = &net->known[net->local];
+
+  // Unacknowledged input is still sent, it can not be overwritten
+  if (*known <= tick + net->delay && *known - net->acked < NET_INPUTS &&
+      *known < tick + NET_INPUTS) {
+    net->inputs[net->local][*known % NET_INPUTS] = input;
+    (*known)++;
+  }
+
+  if (!net->connected || net->known[!net->local] <= tick) {
+    net->stalls++;
+    return false;
+  }
+
+  for (uint i = 0; i < MAX_PLAYERS; i++)
+    inputs[i] = net->inputs[i][tick % NET_INPUTS];
+  return true;
+}
+
+// Keeps a hash of the world once a second, call it after each tick
+void recordNetCheck(GameState *state) {
+  Net *net = &state->net;
+  const uint tick = state->world.tick;
+  if (!net->enabled || tick % TICK_RATE)
+    return;
+
+  net->checks[tick / TICK_RATE % NET_CHECKS] =
+    (struct NetCheck){tick, hashWorld(&state->world)};
+}
+
+// Sends every local input the other side does not have yet, call it once
+// a frame after the ticks
+void sendNet(GameState *state) {
+  Net *net = &state->net;
+  if (!net->enabled || (net->host && !net->connected))
+    return;
+
+  const Uint32 now = SDL_GetTicks();
+  const uint tick = state->world.tick,
+             check = tick / TICK_RATE * TICK_RATE;
+  uint count = net->known[net->local] - net->acked;
+  if (count > NET_PACKET_INPUTS)
+    count = NET_PACKET_INPUTS;
+
+  Uint8 data[NET_PACKET_SIZE];
+  data[0] = NET_MAGIC;
+  data[1] = net->delay;
+  put32(data + 2, net->acked);
+  put32(data + 6, net->known[!net->local]);
+  put16(data + 10, now);
+  put16(data + 12, net->echo);
+  put16(data + 14, net->echo == NO_ECHO ? NO_ECHO : now - net->echoReceived);
+  put32(data + 16, check);
+  put32(data + 20, net->checks[check / TICK_RATE % NET_CHECKS].hash);
+  data[24] = count;
+  for (uint i = 0; i < count; i++)
+    data[NET_HEADER + i] =
+      net->inputs[net->local][(net->acked + i) % NET_INPUTS];
+  queuePacket(state, data, NET_HEADER + count);
+
+  if (now - net->measureStart >= 1000) {
+    net->bytesPerSecond = net->bytes * 1000 / (now - net->measureStart);
+    net->bytes = 0;
+    net->measureStart = now;
+  }
+}
+
+void printNet(GameState *state) {
+  const Net *net = &state->net;
+  const Uint32 elapsed = SDL_GetTicks() - net->start;
+  if (!net->enabled || !elapsed)
+    return;
+
+  printf("Network: %u packets sent, %u lost on purpose, %u received, %.0f "
+         "bytes per second\n",
+         net->sent,
+         net->dropped,
+         net->received,
+         net->totalBytes * 1000.0 / elapsed);
+  printf("  %.1f ms round trip, %.1f ms jitter, waited on the other player "
+         "%u times\n",
+         net->rtt,
+         net->rttJitter,
+         net->stalls);
+}
+
+void freeNet(GameState *state) {
+#ifndef _WIN32
+  if (state->net.socket >= 0)
+    close(state->net.socket);
+#endif
+  state->net.socket = -1;
+}
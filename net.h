@@ -0,0 +1,23 @@
+#ifndef NET_H
+#define NET_H
+
+#include "gameState.h"
+
+void initNet(GameState *state);
+void hostNet(GameState *state, const char *port);
+void joinNet(GameState *state, const char *address);
+void setInputDelay(GameState *state, const char *ticks);
+void simulateNetConditions(GameState *state,
+                           const char *loss,
+                           const char *jitter);
+void startNet(GameState *state);
+void receiveNet(GameState *state);
+bool lockstepInputs(GameState *state,
+                    const Input input,
+                    Input inputs[MAX_PLAYERS]);
+void recordNetCheck(GameState *state);
+void sendNet(GameState *state);
+void printNet(GameState *state);
+void freeNet(GameState *state);
+
+#endif
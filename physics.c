@@ -0,0 +1,132 @@
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include "broadphase.h"
+#include "colliders.h"
+#include "collision.h"
+#include "enemy.h"
+#include "animation.h"
+#include "gameState.h"
+#include "input.h"
+#include "items.h"
+#include "jobs.h"
+
+// Fireballs moved per job, the ones of every player fit in one
+#define BODY_GRAIN 32
+
+// Fireballs are indexed across the players, MAX_FIREBALLS each
+static void moveFireballs(void *data,
+                          const uint chunk,
+                          const uint begin,
+                          const uint end) {
+  Player *players = ((GameState *)data)->world.players;
+  (void)chunk;
+
+  for (uint i = begin; i < end; i++) {
+    Fireball *ball =
+      &players[i / MAX_FIREBALLS].fireballs[i % MAX_FIREBALLS];
+    if (!ball->visible)
+      continue;
+
+    ball->rect.x += ball->velocity.x;
+    ball->rect.y += ball->velocity.y;
+  }
+}
+
+// Sizes the hitbox of a player for this tick and applies its gravity
+static void preparePlayer(Player *player, const Num tile) {
+  // Resolve player hitbox
+  if (player->crounching && player->hitbox.h == tile * 2) {
+    player->hitbox.y += tile;
+    player->hitbox.h = tile;
+  } else if (!player->crounching && player->tall &&
+             player->hitbox.h != tile * 2) {
+    player->hitbox.y -= tile;
+    player->hitbox.h = tile * 2;
+  }
+
+  // Gravity, the player stays in place while it transforms
+  if (!player->transforming && player->velocity.y < MAX_GRAVITY)
+    player->velocity.y += GRAVITY;
+}
+
+// Moves a player once its contacts are resolved
+static void movePlayer(GameState *state, Player *player) {
+  const Num tile = NUM(state->screen.tile);
+
+  player->hitbox.x += player->velocity.x;
+  player->hitbox.y += player->velocity.y;
+
+  // NOTE: Temporary bounds until levels have pits and walls, falling or
+  // walking forever would overflow the fixed-point range
+  const Num w = NUM(state->screen.w), h = NUM(state->screen.h);
+  if (player->hitbox.x > w * 4) {
+    player->hitbox.x = w * 4;
+    player->velocity.x = 0;
+  }
+  if (player->hitbox.y > h * 2) {
+    player->hitbox.y = h * 2;
+    player->velocity.y = 0;
+  }
+
+  // Resolve player rectangle
+  player->rect.y =
+    player->crounching ? player->hitbox.y - tile : player->hitbox.y;
+  player->rect.x = player->hitbox.x;
+  player->rect.x -= tile / 4;
+
+  // Size handling
+  if (player->tall || player->fireForm || player->transforming)
+    player->rect.h = tile * 2;
+  else
+    player->rect.h = tile;
+}
+
+// Apply physics to the players, the objects, and the enemies
+void physics(GameState *state) {
+  World *world = &state->world;
+  const Num tile = NUM(state->screen.tile);
+
+  updateColliders(state);
+  partitionItems(state);
+
+  for (uint i = 0; i < world->playerCount; i++)
+    preparePlayer(&world->players[i], tile);
+  itemGravity(state);
+
+  updateEnemies(state);
+
+  // Every contact is found first, then they all get resolved in order
+  cullBodies(state);
+  broadphase(state);
+  detectContacts(state);
+  resolveContacts(state);
+  removeDeadEnemies(world);
+
+  for (uint i = 0; i < world->playerCount; i++)
+    movePlayer(state, &world->players[i]);
+
+  parallelFor(&state->jobs,
+              world->playerCount * MAX_FIREBALLS,
+              BODY_GRAIN,
+              moveFireballs,
+              state);
+  moveItems(state);
+}
+
+// Advances the world by exactly one tick with the given input of each
+// player. While a player transforms its input is ignored, the rest of the
+// world keeps going.
+void tickPlayers(GameState *state, const Input inputs[MAX_PLAYERS]) {
+  for (uint i = 0; i < state->world.playerCount; i++)
+    if (!state->world.players[i].transforming)
+      applyInput(state, i, inputs[i]);
+  physics(state);
+  animate(state);
+  state->world.tick++;
+}
+
+// Advances a world with a single player by one tick
+void tick(GameState *state, const Input input) {
+  const Input inputs[MAX_PLAYERS] = {input};
+  tickPlayers(state, inputs);
+}
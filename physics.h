@@ -0,0 +1,10 @@
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+#include "gameState.h"
+
+void physics(GameState *state);
+void tickPlayers(GameState *state, const Input inputs[MAX_PLAYERS]);
+void tick(GameState *state, const Input input);
+
+#endif
@@ -3,96 +3,40 @@
 #include <SDL2/SDL_render.h>
 #include <SDL2/SDL_surface.h>
 #include <math.h>
+#include "assets.h"
+#include "capture.h"
+#include "enemy.h"
 #include "gameState.h"
-
-#define BLOCK_SPEED 3
-
-// Shattering animation when player breaks a block
-void blockBreakAnimation(struct Particle *particle, const ushort index) {
-  if (particle->velocity.x == 0) {
-    if (index == 0 || index == 2)
-      particle->velocity.x -= SPEED * 1.2f;
-    else
-      particle->velocity.x += SPEED * 1.2f;
-  }
-
-  if (index < 2 && particle->velocity.y < MAX_GRAVITY * 1.5f)
-    particle->velocity.y += GRAVITY;
-  else if (index >= 2 && particle->velocity.y < MAX_GRAVITY * 1.5f)
-    particle->velocity.y += GRAVITY * 1.25f;
-
-  particle->rect.x += particle->velocity.x;
-  particle->rect.y += particle->velocity.y;
-}
-
-// Bump animation when player hits a Block from below
-void blockAnimation(Block *block, const ushort tile) {
-  if (block->gotHit) {
-    const float goal = block->initY + block->rect.h - tile / 4.0f;
-    if (block->rect.y + block->rect.h > goal)
-      block->rect.y -= BLOCK_SPEED;
-    else
-      block->gotHit = false;
-  } else if (block->rect.y != block->initY)
-    block->rect.y += BLOCK_SPEED;
-}
-
-// Animate items and coins comming out of the block
-void itemAnimation(Block *block, const ushort tile) {
-  if (!block->item.free)
-    return;
-
-  if (block->item.type > COINS) {
-    if (block->item.rect.y > block->initY - tile)
-      block->item.rect.y -= BLOCK_SPEED;
-    else
-      block->type = EMPTY;
-  }
-
-  // When the type Coin be made into type of Coin, make it so onAir is
-  // unnecessary Coins coming out of block
-  if (block->item.type == COINS) {
-    const float COIN_SPEED = BLOCK_SPEED * 3;
-    for (ushort i = 0; i < block->maxCoins; i++) {
-      Coin *coin = &block->coins[i];
-      if (!coin->onAir)
-        continue;
-
-      if (!coin->willFall && coin->rect.y > block->initY - tile * 3)
-        coin->rect.y -= COIN_SPEED;
-      else
-        coin->willFall = true;
-
-      if (coin->willFall && coin->rect.y < block->initY)
-        coin->rect.y += COIN_SPEED;
-      else if (coin->rect.y == block->initY) {
-        coin->willFall = false;
-        coin->onAir = false;
-      }
-    }
-  }
-}
+#include "hud.h"
+#include "items.h"
+#include "latency.h"
+#include "layer.h"
+#include "scheduler.h"
+#include "surface.h"
+#include "timeline.h"
 
 // Handles animations and wich frames all moving parts of the game to be in.
-void handlePlayerFrames(GameState *state) {
-  Player *player = &state->player;
+static void handlePlayerFrames(GameState *state, const uint index) {
+  Player *player = &state->world.players[index];
   const bool isSmall = !player->tall && !player->fireForm,
              jump = player->jumping && !player->crounching,
              walking = player->walking && !player->jumping;
 
-  int animationSpeed = fabsf(player->velocity.x * 0.3f);
+  // Frames follow the ticks of the world so they rewind and replay with it
+  const uint now = state->world.tick * 1000 / TICK_RATE;
+  const Num velocity = NUM_ABS(NUM_MUL(player->velocity.x, NUM(0.3f)));
+  int animationSpeed = NUM_TO_INT(velocity * 64 / state->screen.tile);
 
   if (!animationSpeed)
     animationSpeed = 1;
 
-  const uint walkFrame = SDL_GetTicks() * animationSpeed / 180 % 3;
+  const uint walkFrame = now * animationSpeed / 180 % 3;
 
   // Transofrmation animation
   if (player->transforming && !player->tall) {
-    if (!state->screen.xformTimer)
-      state->screen.xformTimer = SDL_GetTicks();
-
-    const uint elapsedTime = SDL_GetTicks() - state->screen.xformTimer;
+    const uint elapsedTime =
+      sequenceTicks(&state->world, SEQUENCE_TRANSFORM, index) * 1000 /
+      TICK_RATE;
     const uint xformFrame = elapsedTime / 180 % 3;
     int xformTo;
 
@@ -102,34 +46,7 @@ void handlePlayerFrames(GameState *state) {
       xformTo = SMALL_TO_FIRE;
 
     player->frame = xformFrame + xformTo;
-
-    if (elapsedTime >= 2000) {
-      player->transforming = false;
-      player->tall = true;
-    } else
-      return;
-  }
-
-  // Star timer
-  if (player->invincible) {
-    if (!state->screen.starTimer)
-      state->screen.starTimer = SDL_GetTicks();
-
-    if (SDL_GetTicks() - state->screen.starTimer > 20 * 1000) {
-      state->screen.starTimer = 0;
-      player->invincible = false;
-    }
-  }
-
-  // Firing timer
-  if (player->firing) {
-    if (!state->screen.firingTimer)
-      state->screen.firingTimer = SDL_GetTicks();
-
-    if (SDL_GetTicks() - state->screen.firingTimer > 200) {
-      state->screen.firingTimer = 0;
-      player->firing = false;
-    }
+    return;
   }
 
   if (isSmall) {
@@ -169,7 +86,7 @@ void handlePlayerFrames(GameState *state) {
 
   // Star form animation
   if (player->invincible) {
-    const uint starFrame = SDL_GetTicks() / 90 % 4;
+    const uint starFrame = now / 90 % 4;
     if (!player->fireForm)
       player->frame += starFrame * 7;
     else if (!player->firing) {
@@ -182,144 +99,259 @@ void handlePlayerFrames(GameState *state) {
   }
 }
 
-// If it is not free, then it will be static
-ushort handleItemFrames(Item *item) {
-  enum { FLOWER_FRAME = 2, STAR_FRAME = 6, COIN_FRAME = 10 };
-  const ushort velocity = item->type == COINS ? 100 : 180;
-  ushort itemFrame = item->free ? SDL_GetTicks() / velocity % 4 : 0;
-
-  if (item->type == FIRE_FLOWER)
-    return itemFrame + FLOWER_FRAME;
-  else if (item->type == STAR)
-    return itemFrame + STAR_FRAME;
-  else
-    return itemFrame + COIN_FRAME;
+// Draws a frame of a sprite sheet. Flipped frames come from the mirrored
+// copy of the sheet when it has one, since flipping on the fly is slow on
+// the software renderer.
+// @param mirrored: The sheet mirrored horizontally, can be NULL
+void drawSprite(GameState *state,
+                SDL_Texture *texture,
+                SDL_Texture *mirrored,
+                const SDL_Rect *src,
+                const SDL_FRect *dst,
+                const bool flip) {
+  traceSprite(state, dst, spriteKey(texture, src, flip));
+  for (uint cursor = 0; clipSprite(state, dst, &cursor);) {
+    if (!flip) {
+      SDL_RenderCopyF(state->renderer, texture, src, dst);
+      continue;
+    }
+    if (!mirrored) {
+      SDL_RenderCopyExF(
+        state->renderer, texture, src, dst, 0, NULL, SDL_FLIP_HORIZONTAL);
+      continue;
+    }
+
+    int w;
+    SDL_QueryTexture(mirrored, NULL, NULL, &w, NULL);
+    const SDL_Rect mirroredSrc = {
+      w - src->x - src->w, src->y, src->w, src->h};
+    SDL_RenderCopyF(state->renderer, mirrored, &mirroredSrc, dst);
+  }
 }
 
-// Renders to the screen
-void render(GameState *state) {
-  handlePlayerFrames(state);
-  Player *player = &state->player;
-  Sheets *sheets = &state->sheets;
-  Screen *screen = &state->screen;
-  ushort tile = screen->tile;
+// Fills a rectangle with a flat color
+static void drawBox(GameState *state,
+                    const SDL_Color color,
+                    const SDL_FRect *dst) {
+  traceSprite(state,
+              dst,
+              spriteKey(NULL,
+                        NULL,
+                        (Uint32)color.r << 24 | color.g << 16 |
+                          color.b << 8 | color.a));
+  SDL_SetRenderDrawColor(state->renderer, color.r, color.g, color.b, color.a);
+  for (uint cursor = 0; clipSprite(state, dst, &cursor);)
+    SDL_RenderFillRectF(state->renderer, dst);
+}
 
-  SDL_SetRenderDrawColor(state->renderer, 92, 148, 252, 255);
-  SDL_RenderClear(state->renderer);
+// Upscales the native resolution frame by the largest integer factor that
+// fits the window, centered with black borders, then presents it
+void presentFrame(GameState *state) {
+  if (state->surface.enabled) {
+    captureFrame(state);
+    markRendered(state);
+    presentSurface(state);
+    markPresented(state);
+    return;
+  }
+  if (!state->target) {
+    markRendered(state);
+    SDL_RenderPresent(state->renderer);
+    markPresented(state);
+    return;
+  }
 
-  SDL_SetRenderDrawColor(state->renderer, 255, 0, 0, 255);
-  // NOTES: Delmiter of the bottom of the screen
-  SDL_RenderDrawLine(state->renderer, 0, screen->h, screen->w, screen->h);
+  int w, h;
+  SDL_GetRendererOutputSize(state->renderer, &w, &h);
+  const int xscale = w / state->screen.w, yscale = h / state->screen.h;
+  int scale = xscale < yscale ? xscale : yscale;
+  if (scale < 1)
+    scale = 1;
 
-  SDL_Rect srcground = {0, 16, 32, 32};
-  SDL_FRect dstground = {0, screen->h - tile * 2, tile * 2, tile * 2};
+  const SDL_Rect dst = {(w - (int)state->screen.w * scale) / 2,
+                        (h - (int)state->screen.h * scale) / 2,
+                        state->screen.w * scale,
+                        state->screen.h * scale};
 
-  // Rendering ground
-  // TODO: This method is very limitating, because it does not follow a map
-  // NOTE: This must be behind the block breaking bits
-  for (uint i = 0; i < state->objsLength; i++) {
-    state->objs[i] = dstground;
-    SDL_RenderCopyF(state->renderer, sheets->objs, &srcground, &dstground);
-    dstground.x += dstground.w;
-  }
+  // Read back before upscaling, it is a fraction of the pixels
+  captureFrame(state);
 
-  // Rendering blocks
-  for (uint i = 0; i < state->blocksLenght; i++) {
-    Block *block = &state->blocks[i];
+  SDL_SetRenderTarget(state->renderer, NULL);
+  SDL_SetRenderDrawColor(state->renderer, 0, 0, 0, 255);
+  SDL_RenderClear(state->renderer);
+  SDL_RenderCopy(state->renderer, state->target, NULL, &dst);
+  markRendered(state);
+  SDL_RenderPresent(state->renderer);
+  markPresented(state);
+}
 
-    // Handling item frames
-    if (block->type != NOTHING && block->item.visible &&
-        block->item.type != COINS) {
-      Item *item = &block->item;
-      ushort frame;
+// Sky with a progress bar, shown until every sprite sheet is uploaded
+static void renderLoading(GameState *state) {
+  const Screen *screen = &state->screen;
+  const float progress = assetsProgress(state);
+  const SDL_Rect frame = {screen->w / 4,
+                          screen->h / 2 - screen->tile / 4,
+                          screen->w / 2,
+                          screen->tile / 2};
+  const SDL_Rect bar = {frame.x, frame.y, (int)(frame.w * progress), frame.h};
 
-      if (item->type == MUSHROOM)
-        frame = 0;
-      else
-        frame = handleItemFrames(item);
+  SDL_SetRenderDrawColor(state->renderer, 92, 148, 252, 255);
+  SDL_RenderClear(state->renderer);
+  SDL_SetRenderDrawColor(state->renderer, 255, 255, 255, 255);
+  SDL_RenderDrawRect(state->renderer, &frame);
+  SDL_RenderFillRect(state->renderer, &bar);
+  invalidateSurface(state);
+  presentFrame(state);
+}
 
-      // Rendering Items
-      SDL_RenderCopyF(
-        state->renderer, sheets->items, &sheets->srcitems[frame], &item->rect);
-    } else if (block->type != NOTHING && block->item.type == COINS) {
+// Collects where the debris and the coin arcs of every block are drawn.
+// Frames short on time skip this and draw the last ones again, so they
+// move at a lower rate instead of disappearing.
+// @param now: Milliseconds of world time, picks the coin frames
+static void gatherEffects(GameState *state, const uint now) {
+  Effects *effects = &state->effects;
+  const Num h = NUM(state->screen.h);
+  effects->count = 0;
+
+  for (uint i = 0; i < state->world.blocksLenght; i++) {
+    const Block *block = &state->world.blocks[i];
+
+    if (block->type != NOTHING && !itemBehaviors[block->item.type].powerUp) {
+      const ushort frame = itemFrame(&block->item, now);
       for (ushort j = 0; j < block->maxCoins; j++) {
-        Coin *coin = &block->coins[j];
-        if (!coin->onAir)
+        if (!block->coins[j].onAir)
           continue;
-        ushort frame = handleItemFrames(&block->item);
-
-        SDL_RenderCopyF(state->renderer,
-                        sheets->items,
-                        &sheets->srcitems[frame],
-                        &coin->rect);
+        const SDL_FRect dst = boxToFRect(block->coins[j].rect);
+        effects->list[effects->count++] = (struct Effect){dst, frame, false};
       }
     }
 
-    // Animating items
-    if (block->type != NOTHING) {
-      itemAnimation(block, screen->tile);
-      if ((block->item.type != COINS && block->item.free) ||
-          (block->item.type == COINS && !block->coinCount))
-        block->sprite = EMPTY_SPRITE;
+    if (!block->broken)
+      continue;
+    for (ushort j = 0; j < MAX_BLOCK_PARTICLES; j++) {
+      if (block->particles[j].rect.y >= h)
+        continue;
+      const SDL_FRect dst = boxToFRect(block->particles[j].rect);
+      effects->list[effects->count++] = (struct Effect){dst, j, true};
     }
+  }
+}
 
-    // Rendering blocks or broken block's particles
-    if (!block->broken) {
-      // Animating blocks
-      if ((block->type != EMPTY && block->gotHit) ||
-          block->rect.y != block->initY)
-        blockAnimation(block, screen->tile);
-
-      SDL_RenderCopyF(state->renderer,
-                      sheets->objs,
-                      &sheets->srcsobjs[block->sprite],
-                      &block->rect);
-    } else {
-      for (ushort j = 0; j < MAX_BLOCK_PARTICLES; j++) {
-        struct Particle *particle = &block->particles[j];
+// Draws everything in the world, back to front
+static void drawScene(GameState *state) {
+  Sheets *sheets = &state->sheets;
+  const uint now = state->world.tick * 1000 / TICK_RATE;
+
+  // Sky and ground, must be behind the block breaking bits
+  renderStaticLayer(state);
+
+  // Behind the blocks, so coins fall back into theirs
+  if (scheduleWork(state, WORK_COSMETIC))
+    gatherEffects(state, now);
+  for (uint i = 0; i < state->effects.count; i++) {
+    const struct Effect *effect = &state->effects.list[i];
+    SDL_Texture *sheet = effect->debris ? sheets->effects : sheets->items;
+    const SDL_Rect *src = effect->debris ? &sheets->srceffects[effect->frame]
+                                         : &sheets->srcitems[effect->frame];
+    drawSprite(state, sheet, NULL, src, &effect->dst, false);
+  }
 
-        if (particle->rect.y >= screen->h)
-          continue;
+  // Rendering blocks
+  for (uint i = 0; i < state->world.blocksLenght; i++) {
+    Block *block = &state->world.blocks[i];
 
-        blockBreakAnimation(particle, j);
+    // Handling item frames
+    if (block->type != NOTHING && block->item.visible &&
+        itemBehaviors[block->item.type].powerUp) {
+      Item *item = &block->item;
+      const ushort frame = itemFrame(item, now);
 
-        SDL_RenderCopyF(state->renderer,
-                        sheets->effects,
-                        &sheets->srceffects[j],
-                        &particle->rect);
-      }
+      // Rendering Items
+      const SDL_FRect dst = boxToFRect(item->rect);
+      drawSprite(
+        state, sheets->items, NULL, &sheets->srcitems[frame], &dst, false);
+    }
+
+    // Rendering blocks, their debris is drawn with the effects
+    if (!block->broken) {
+      const SDL_FRect dst = boxToFRect(block->rect);
+      drawSprite(state,
+                 sheets->objs,
+                 NULL,
+                 &sheets->srcsobjs[block->sprite],
+                 &dst,
+                 false);
     }
   }
 
-  // Size handling
-  if (player->tall || player->fireForm || player->transforming)
-    player->rect.h = tile * 2;
-  else
-    player->rect.h = tile;
+  // Rendering enemies, as plain rectangles until they get sprites
+  const Enemies *enemies = &state->world.enemies;
+  for (uint i = 0; i < enemies->count; i++) {
+    const SDL_Color koopa = {0, 168, 0, 255}, goomba = {200, 76, 12, 255};
+    const SDL_FRect dst =
+      boxToFRect(enemyBox(enemies, i, NUM(state->screen.tile)));
+    drawBox(state, enemies->type[i] == KOOPA ? koopa : goomba, &dst);
+  }
 
   // TODO: Add a debug mode to see all collisions
   // SDL_RenderDrawRectF(state->renderer, &player->hitbox);
 
-  SDL_RenderCopyExF(state->renderer,
-                    sheets->mario,
-                    &sheets->srcmario[player->frame],
-                    &player->rect,
-                    0,
-                    NULL,
-                    player->facingRight ? SDL_FLIP_NONE : SDL_FLIP_HORIZONTAL);
-
-  // Rendering fireballs
-  for (ushort i = 0; i < MAX_FIREBALLS; i++) {
-    Fireball *ball = &player->fireballs[i];
-    if (!ball->visible)
-      continue;
+  for (uint p = 0; p < state->world.playerCount; p++) {
+    const Player *player = &state->world.players[p];
+
+    // The second player is told apart by a greener shade
+    const Uint8 shade = p ? 160 : 255;
+    SDL_SetTextureColorMod(sheets->mario, shade, 255, shade);
+    SDL_SetTextureColorMod(sheets->marioMirrored, shade, 255, shade);
+
+    // Flickers while enemies cannot hurt it
+    if (!player->hurt || state->world.tick / 4 % 2) {
+      const SDL_FRect dstplayer = boxToFRect(player->rect);
+      drawSprite(state,
+                 sheets->mario,
+                 sheets->marioMirrored,
+                 &sheets->srcmario[player->frame],
+                 &dstplayer,
+                 !player->facingRight);
+    }
 
-    const ushort frame = SDL_GetTicks() / 180 % 4 + 4;
+    // Rendering fireballs
+    for (ushort i = 0; i < MAX_FIREBALLS; i++) {
+      const Fireball *ball = &player->fireballs[i];
+      if (!ball->visible)
+        continue;
+
+      const ushort frame = now / 180 % 4 + 4;
 
-    SDL_RenderCopyF(state->renderer,
-                    sheets->effects,
-                    &sheets->srceffects[frame],
-                    &ball->rect);
+      const SDL_FRect dst = boxToFRect(ball->rect);
+      drawSprite(
+        state, sheets->effects, NULL, &sheets->srceffects[frame], &dst, false);
+    }
   }
-  SDL_RenderPresent(state->renderer);
+
+  renderHud(state);
+}
+
+// Renders to the screen
+void render(GameState *state) {
+  if (scheduleWork(state, WORK_DEFERRABLE))
+    uploadAssets(state);
+  if (state->target)
+    SDL_SetRenderTarget(state->renderer, state->target);
+  if (!assetsLoaded(state)) {
+    renderLoading(state);
+    return;
+  }
+  for (uint i = 0; i < state->world.playerCount; i++)
+    handlePlayerFrames(state, i);
+  updateHud(state);
+
+  // On the window surface, a first pass finds what changed and the second
+  // one only redraws that
+  if (beginSurfaceTrace(state)) {
+    drawScene(state);
+    endSurfaceTrace(state);
+  }
+  drawScene(state);
+  presentFrame(state);
 }
@@ -3,6 +3,12 @@
 
 #include "gameState.h"
 
+void drawSprite(GameState *state,
+                SDL_Texture *texture,
+                SDL_Texture *mirrored,
+                const SDL_Rect *src,
+                const SDL_FRect *dst,
+                const bool flip);
 void render(GameState *state);
 
 #endif
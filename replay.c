@@ -0,0 +1,192 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_rwops.h>
+#include "gameState.h"
+#include "physics.h"
+#include "replay.h"
+#include "utils.h"
+
+// File layout: magic, version, sizeof(Num) and the tick count, each as a
+// little endian Uint32, followed by one Input per tick.
+#define REPLAY_MAGIC 0x5043524d // "MRCP"
+#define REPLAY_VERSION 1
+#define HEADER_SIZE 16
+
+static void writeHeader(Replay *replay) {
+  const Uint32 fields[] = {
+    REPLAY_MAGIC, REPLAY_VERSION, sizeof(Num), replay->count};
+  Uint8 header[HEADER_SIZE];
+
+  for (uint i = 0; i < HEADER_SIZE; i++)
+    header[i] = fields[i / 4] >> (i % 4 * 8) & 0xff;
+  SDL_RWseek(replay->file, 0, RW_SEEK_SET);
+  SDL_RWwrite(replay->file, header, HEADER_SIZE, 1);
+}
+
+// Creates a replay file, overwriting it if it already exists
+// @return false if the file could not be created
+bool openReplay(Replay *replay, const char *path) {
+  replay->file = SDL_RWFromFile(path, "wb");
+  if (!replay->file) {
+    printf("Could not create the replay! SDL_Error: %s\n", SDL_GetError());
+    return false;
+  }
+  replay->count = 0;
+  writeHeader(replay);
+  return true;
+}
+
+// Stores the input of a tick. Going back in time overwrites the inputs that
+// came after, so the file always matches the timeline that was kept.
+void recordInput(Replay *replay, const uint tick, const Input input) {
+  if (!replay->file)
+    return;
+
+  SDL_RWseek(replay->file, HEADER_SIZE + tick, RW_SEEK_SET);
+  SDL_RWwrite(replay->file, &input, 1, 1);
+  replay->count = tick + 1;
+}
+
+void closeReplay(Replay *replay) {
+  if (!replay->file)
+    return;
+
+  writeHeader(replay);
+  SDL_RWclose(replay->file);
+  replay->file = NULL;
+}
+
+static Uint64 hashBytes(Uint64 hash, const void *data, const size_t size) {
+  const Uint8 *bytes = data;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+// FNV-1a of every simulated field of the world. Fields are hashed one by one
+// so struct padding and presentation only fields never change the result.
+Uint64 hashWorld(const World *world) {
+  Uint64 hash = 0xcbf29ce484222325;
+#define HASH(field)                                                            \
+  do {                                                                         \
+    const __typeof__(field) value = (field);                                   \
+    hash = hashBytes(hash, &value, sizeof(value));                             \
+  } while (0)
+
+  for (uint p = 0; p < world->playerCount; p++) {
+    const Player *player = &world->players[p];
+    HASH(player->rect);
+    HASH(player->hitbox);
+    HASH(player->velocity);
+    HASH(player->tall);
+    HASH(player->fireForm);
+    HASH(player->invincible);
+    HASH(player->transforming);
+    HASH(player->onSurface);
+    HASH(player->jumping);
+    HASH(player->facingRight);
+    HASH(player->walking);
+    HASH(player->crounching);
+    HASH(player->firing);
+    HASH(player->hurt);
+    HASH(player->coins);
+    HASH(player->score);
+    for (ushort i = 0; i < MAX_FIREBALLS; i++) {
+      HASH(player->fireballs[i].rect);
+      HASH(player->fireballs[i].velocity);
+      HASH(player->fireballs[i].visible);
+    }
+  }
+
+  for (uint i = 0; i < world->blocksLenght; i++) {
+    const Block *block = &world->blocks[i];
+    HASH(block->rect);
+    HASH(block->initY);
+    HASH(block->gotHit);
+    HASH(block->broken);
+    HASH(block->type);
+    HASH(block->sprite);
+    HASH(block->item.rect);
+    HASH(block->item.velocity);
+    HASH(block->item.free);
+    HASH(block->item.visible);
+    HASH(block->item.type);
+    HASH(block->coinCount);
+    for (ushort j = 0; j < MAX_BLOCK_PARTICLES; j++) {
+      HASH(block->particles[j].rect);
+      HASH(block->particles[j].velocity);
+    }
+    for (ushort j = 0; j < block->maxCoins; j++) {
+      HASH(block->coins[j].rect);
+      HASH(block->coins[j].onAir);
+      HASH(block->coins[j].willFall);
+    }
+  }
+
+  for (uint i = 0; i < world->objsLength; i++)
+    HASH(world->objs[i]);
+  const Enemies *enemies = &world->enemies;
+  for (uint i = 0; i < enemies->count; i++) {
+    HASH(enemies->x[i]);
+    HASH(enemies->y[i]);
+    HASH(enemies->vx[i]);
+    HASH(enemies->vy[i]);
+    HASH(enemies->type[i]);
+    HASH(enemies->lod[i]);
+  }
+  for (uint i = 0; i < MAX_SEQUENCES; i++) {
+    const Sequence *sequence = &world->sequences[i];
+    HASH(sequence->type);
+    if (!sequence->type)
+      continue;
+    HASH(sequence->target);
+    HASH(sequence->index);
+    HASH(sequence->step);
+    HASH(sequence->wait);
+    HASH(sequence->ticks);
+  }
+  HASH(world->tick);
+  for (uint p = 0; p < world->playerCount; p++) {
+    HASH(world->lastInput[p]);
+    HASH(world->holdingJump[p]);
+  }
+#undef HASH
+
+  return hash;
+}
+
+// Runs a recorded replay as fast as possible, without rendering, then
+// prints the hash of the final world. Builds that agree on the hash
+// simulated every tick the same way.
+void runReplay(GameState *state, const char *path) {
+  SDL_RWops *file = SDL_RWFromFile(path, "rb");
+  if (!file) {
+    printf("Could not open the replay! SDL_Error: %s\n", SDL_GetError());
+    quit(state, 1);
+  }
+
+  Uint8 header[HEADER_SIZE];
+  Uint32 fields[HEADER_SIZE / 4] = {0};
+  if (SDL_RWread(file, header, HEADER_SIZE, 1))
+    for (uint i = 0; i < HEADER_SIZE; i++)
+      fields[i / 4] |= (Uint32)header[i] << (i % 4 * 8);
+  if (fields[0] != REPLAY_MAGIC || fields[1] != REPLAY_VERSION ||
+      fields[2] != sizeof(Num)) {
+    printf("The replay %s is invalid or from another number type\n", path);
+    SDL_RWclose(file);
+    quit(state, 1);
+  }
+
+  const Uint64 start = SDL_GetPerformanceCounter();
+  Input input;
+  for (uint i = 0; i < fields[3] && SDL_RWread(file, &input, 1, 1); i++)
+    tick(state, input);
+  const double elapsed = (SDL_GetPerformanceCounter() - start) /
+                         (double)SDL_GetPerformanceFrequency();
+  SDL_RWclose(file);
+
+  printf("Replayed %u ticks in %.3f s\n", state->world.tick, elapsed);
+  printf("World hash: %016llx\n",
+         (unsigned long long)hashWorld(&state->world));
+}
@@ -0,0 +1,12 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "gameState.h"
+
+bool openReplay(Replay *replay, const char *path);
+void recordInput(Replay *replay, const uint tick, const Input input);
+void closeReplay(Replay *replay);
+Uint64 hashWorld(const World *world);
+void runReplay(GameState *state, const char *path);
+
+#endif
@@ -0,0 +1,70 @@
+#include <SDL2/SDL.h>
+#include "gameState.h"
+#include "scheduler.h"
+
+// The share of the budget after which each class starts being skipped, in
+// quarters, critical work always runs
+static const uint thresholds[WORK_CLASSES] = {4, 3, 2};
+
+static const char *const names[WORK_CLASSES] = {
+  "critical", "deferrable", "cosmetic"};
+
+// @param budgetMs: The time a frame may take before work gets skipped
+void initScheduler(GameState *state, const double budgetMs) {
+  Scheduler *scheduler = &state->scheduler;
+  *scheduler = (Scheduler){0};
+  scheduler->budget = budgetMs * SDL_GetPerformanceFrequency() / 1000;
+}
+
+// Starts measuring a frame, call it before handling its input
+void beginFrame(GameState *state) {
+  Scheduler *scheduler = &state->scheduler;
+  scheduler->frameStart = SDL_GetPerformanceCounter();
+  scheduler->frame++;
+  scheduler->degradedFrame = false;
+}
+
+// Whether to run a piece of work this frame. Every call for a class in the
+// same frame gets the answer of the first one, so a class is either fully
+// drawn or fully skipped. No class is skipped for more than
+// MAX_DEFERRED_FRAMES in a row.
+bool scheduleWork(GameState *state, const WorkClass work) {
+  Scheduler *scheduler = &state->scheduler;
+  if (work == WORK_CRITICAL || !scheduler->budget)
+    return true;
+  if (scheduler->decided[work] == scheduler->frame)
+    return scheduler->allowed[work];
+
+  const Uint64 elapsed = SDL_GetPerformanceCounter() - scheduler->frameStart;
+  const bool allowed =
+    elapsed * 4 < scheduler->budget * thresholds[work] ||
+    scheduler->frame - scheduler->lastRun[work] >= MAX_DEFERRED_FRAMES;
+
+  scheduler->decided[work] = scheduler->frame;
+  scheduler->allowed[work] = allowed;
+  if (allowed)
+    scheduler->lastRun[work] = scheduler->frame;
+  else {
+    scheduler->deferred[work]++;
+    if (!scheduler->degradedFrame)
+      scheduler->degraded++;
+    scheduler->degradedFrame = true;
+  }
+  return allowed;
+}
+
+void printScheduler(GameState *state) {
+  const Scheduler *scheduler = &state->scheduler;
+  if (!scheduler->frame)
+    return;
+
+  printf("Frame budget of %.2f ms: %u of %u frames degraded (%.1f%%)\n",
+         scheduler->budget * 1e3 / SDL_GetPerformanceFrequency(),
+         scheduler->degraded,
+         scheduler->frame,
+         scheduler->degraded * 100.0 / scheduler->frame);
+  for (uint i = WORK_CRITICAL + 1; i < WORK_CLASSES; i++)
+    printf("  %s work deferred on %u frames\n",
+           names[i],
+           scheduler->deferred[i]);
+}
@@ -0,0 +1,11 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "gameState.h"
+
+void initScheduler(GameState *state, const double budgetMs);
+void beginFrame(GameState *state);
+bool scheduleWork(GameState *state, const WorkClass work);
+void printScheduler(GameState *state);
+
+#endif
@@ -0,0 +1,126 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_timer.h>
+#include "gameState.h"
+#include "physics.h"
+#include "snapshot.h"
+#include "utils.h"
+
+// Allocates the snapshot ring and stores the initial world in it
+void initSnapshots(GameState *state) {
+  Snapshots *snaps = &state->snapshots;
+  snaps->frames = malloc(sizeof(World) * SNAPSHOT_COUNT);
+  if (snaps->frames == NULL) {
+    printf("Could not allocate memory for the snapshots\n");
+    quit(state, 1);
+  }
+  snaps->head = 0;
+  snaps->count = 0;
+  snaps->hasSaved = false;
+  snaps->rewinding = false;
+  saveSnapshot(state);
+}
+
+// Pushes the current world into the ring, overwriting the oldest one when full
+void saveSnapshot(GameState *state) {
+  Snapshots *snaps = &state->snapshots;
+  snaps->frames[snaps->head] = state->world;
+  snaps->head = (snaps->head + 1) % SNAPSHOT_COUNT;
+  if (snaps->count < SNAPSHOT_COUNT)
+    snaps->count++;
+}
+
+// Restores the world from some ticks ago, keeping the newer snapshots
+// @param ticksBack: 0 is the newest snapshot
+// @return false if the ring does not go that far back
+bool loadSnapshot(GameState *state, const uint ticksBack) {
+  Snapshots *snaps = &state->snapshots;
+  if (ticksBack >= snaps->count)
+    return false;
+
+  const uint index =
+    (snaps->head + SNAPSHOT_COUNT * 2 - 1 - ticksBack) % SNAPSHOT_COUNT;
+  state->world = snaps->frames[index];
+  return true;
+}
+
+// Goes back in time, dropping the snapshots newer than the restored one
+// @return false if the ring does not go that far back
+bool rewindSnapshot(GameState *state, const uint ticks) {
+  Snapshots *snaps = &state->snapshots;
+  if (!ticks || !loadSnapshot(state, ticks))
+    return false;
+
+  snaps->count -= ticks;
+  snaps->head = (snaps->head + SNAPSHOT_COUNT - ticks) % SNAPSHOT_COUNT;
+  return true;
+}
+
+// Replaces the last ticks with a corrected input and simulates them again
+// @param inputs: The input of each tick, from oldest to newest
+// @param count: How many ticks to go back and re-simulate
+// @return false if the ring does not go that far back
+bool rollback(GameState *state, const Input inputs[], const uint count) {
+  if (!rewindSnapshot(state, count))
+    return false;
+
+  for (uint i = 0; i < count; i++) {
+    tick(state, inputs[i]);
+    saveSnapshot(state);
+  }
+  return true;
+}
+
+void saveState(GameState *state) {
+  state->snapshots.saved = state->world;
+  state->snapshots.hasSaved = true;
+}
+
+void loadState(GameState *state) {
+  if (!state->snapshots.hasSaved)
+    return;
+  state->world = state->snapshots.saved;
+  saveSnapshot(state);
+}
+
+// Measures the cost of snapshots, restores and 8 tick rollback windows.
+// The world is left in an undefined state, quit after calling this.
+void benchSnapshots(GameState *state) {
+  const uint iterations = 100000, windows = 10000, window = 8;
+  const double freq = SDL_GetPerformanceFrequency();
+  Input inputs[8] = {INPUT_RIGHT,
+                     INPUT_RIGHT,
+                     INPUT_RIGHT | INPUT_UP | INPUT_JUMP,
+                     INPUT_RIGHT | INPUT_UP | INPUT_JUMP,
+                     INPUT_RIGHT,
+                     0,
+                     INPUT_LEFT,
+                     INPUT_LEFT};
+  state->screen.deltaTime = 1.0f / state->screen.targetFps;
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (uint i = 0; i < iterations; i++)
+    saveSnapshot(state);
+  const double saveTime = (SDL_GetPerformanceCounter() - start) / freq;
+
+  start = SDL_GetPerformanceCounter();
+  for (uint i = 0; i < iterations; i++)
+    loadSnapshot(state, i % SNAPSHOT_COUNT);
+  const double loadTime = (SDL_GetPerformanceCounter() - start) / freq;
+
+  for (uint i = 0; i < window; i++) {
+    tick(state, inputs[i]);
+    saveSnapshot(state);
+  }
+  start = SDL_GetPerformanceCounter();
+  for (uint i = 0; i < windows; i++)
+    rollback(state, inputs, window);
+  const double resimTime = (SDL_GetPerformanceCounter() - start) / freq;
+
+  printf("World size: %zu bytes\n", sizeof(World));
+  printf("Snapshot: %.3f us\n", saveTime * 1e6 / iterations);
+  printf("Restore: %.3f us\n", loadTime * 1e6 / iterations);
+  printf("Rollback of %u ticks: %.3f us (%.3f us per tick)\n",
+         window,
+         resimTime * 1e6 / windows,
+         resimTime * 1e6 / windows / window);
+}
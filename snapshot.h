@@ -0,0 +1,15 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "gameState.h"
+
+void initSnapshots(GameState *state);
+void saveSnapshot(GameState *state);
+bool loadSnapshot(GameState *state, const uint ticksBack);
+bool rewindSnapshot(GameState *state, const uint ticks);
+bool rollback(GameState *state, const Input inputs[], const uint count);
+void saveState(GameState *state);
+void loadState(GameState *state);
+void benchSnapshots(GameState *state);
+
+#endif
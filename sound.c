@@ -0,0 +1,168 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_atomic.h>
+#include <SDL2/SDL_audio.h>
+#include "gameState.h"
+#include "sound.h"
+#include "utils.h"
+
+// Of a single voice, all of them playing at once still fit in 16 bits
+#define VOLUME 3000
+// Samples mixed per callback, about 12 ms of latency
+#define MIX_SAMPLES 512
+#define TONES 3
+
+// A square wave sliding from one pitch to the other, or noise without one
+typedef struct {
+  float seconds, from, to;
+} Tone;
+
+static const Tone tones[SOUND_COUNT][TONES] = {
+  [SOUND_COIN] = {{0.06f, 988, 988}, {0.3f, 1319, 1319}},
+  [SOUND_BUMP] = {{0.08f, 180, 90}},
+  [SOUND_BREAK] = {{0.25f, 0, 0}},
+  [SOUND_POWERUP] = {{0.08f, 523, 523}, {0.08f, 659, 659}, {0.2f, 784, 1047}},
+  [SOUND_FIREBALL] = {{0.06f, 1200, 300}},
+  [SOUND_STOMP] = {{0.1f, 400, 100}},
+  [SOUND_JUMP] = {{0.15f, 300, 900}},
+};
+
+// Renders a sound effect into memory once, so playing it is only a copy
+static void synthesize(GameState *state, const SoundId id) {
+  Sample *sample = &state->sound.samples[id];
+  uint length = 0;
+  for (uint i = 0; i < TONES; i++)
+    length += tones[id][i].seconds * SAMPLE_RATE;
+
+  sample->samples = malloc(length * sizeof(Sint16));
+  if (!sample->samples) {
+    printf("Could not allocate memory for the sound effects\n");
+    quit(state, 1);
+  }
+
+  Uint16 noise = 1;
+  float phase = 0;
+  for (uint i = 0; i < TONES; i++) {
+    const Tone *tone = &tones[id][i];
+    const uint count = tone->seconds * SAMPLE_RATE;
+
+    for (uint j = 0; j < count; j++) {
+      const float progress = (float)j / count;
+      const Sint16 volume = VOLUME * (1 - progress);
+      bool high;
+      if (!tone->from) {
+        // The 15 bit shift register of the NES noise channel
+        noise = (noise >> 1) | (((noise ^ (noise >> 1)) & 1) << 14);
+        high = noise & 1;
+      } else {
+        phase += (tone->from + (tone->to - tone->from) * progress) /
+                 SAMPLE_RATE;
+        if (phase >= 1)
+          phase -= 1;
+        high = phase < 0.5f;
+      }
+      sample->samples[sample->length++] = high ? volume : -volume;
+    }
+  }
+}
+
+// Takes a free voice, or the one that has been playing the longest
+static void startVoice(Sound *sound, const Uint8 id) {
+  Voice *voice = &sound->voices[0];
+  for (uint i = 0; i < MAX_VOICES; i++) {
+    Voice *other = &sound->voices[i];
+    if (!other->playing) {
+      voice = other;
+      break;
+    }
+    if (other->position > voice->position)
+      voice = other;
+  }
+  *voice = (Voice){.playing = true, .sound = id, .position = 0};
+}
+
+// Runs on the audio thread, it must never wait on the simulation
+static void mixSounds(void *data, Uint8 *stream, int length) {
+  Sound *sound = data;
+  Sint16 *out = (Sint16 *)stream;
+  const uint count = length / sizeof(Sint16);
+
+  // Start everything queued since the last call
+  const int head = SDL_AtomicGet(&sound->head);
+  int tail = SDL_AtomicGet(&sound->tail);
+  for (; tail != head; tail++)
+    startVoice(sound, sound->queue[tail & (SOUND_QUEUE_SIZE - 1)]);
+  SDL_AtomicSet(&sound->tail, tail);
+
+  for (uint i = 0; i < count; i++) {
+    int mixed = 0;
+    for (uint j = 0; j < MAX_VOICES; j++) {
+      Voice *voice = &sound->voices[j];
+      if (!voice->playing)
+        continue;
+
+      const Sample *sample = &sound->samples[voice->sound];
+      mixed += sample->samples[voice->position++];
+      if (voice->position == sample->length)
+        voice->playing = false;
+    }
+    out[i] = mixed > 32767 ? 32767 : mixed < -32768 ? -32768 : mixed;
+  }
+}
+
+// Opens the audio device and prepares every sound effect. Without a device
+// the game just stays silent, SDL_AUDIODRIVER=dummy works headless.
+void initSound(GameState *state) {
+  Sound *sound = &state->sound;
+  if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+    printf("Could not initialize the audio! SDL_Error: %s\n", SDL_GetError());
+    return;
+  }
+
+  SDL_AudioSpec spec = {.freq = SAMPLE_RATE,
+                        .format = AUDIO_S16SYS,
+                        .channels = 1,
+                        .samples = MIX_SAMPLES,
+                        .callback = mixSounds,
+                        .userdata = sound};
+  sound->device = SDL_OpenAudioDevice(NULL, 0, &spec, NULL, 0);
+  if (!sound->device) {
+    printf("Could not open the audio device! SDL_Error: %s\n", SDL_GetError());
+    return;
+  }
+
+  // The device starts paused, so the callback cannot see half made samples
+  for (uint i = 0; i < SOUND_COUNT; i++)
+    synthesize(state, i);
+  SDL_PauseAudioDevice(sound->device, 0);
+}
+
+// Queues a sound effect to start on the next audio callback. Only call it
+// from the simulation thread, if the queue is full the sound is dropped.
+void playSound(GameState *state, const SoundId id) {
+  Sound *sound = &state->sound;
+  // Fast forwarded sounds would only pile up into noise
+  if (!sound->device || state->speed.fastForward)
+    return;
+
+  const int head = SDL_AtomicGet(&sound->head);
+  if ((uint)head - (uint)SDL_AtomicGet(&sound->tail) >= SOUND_QUEUE_SIZE) {
+    sound->dropped++;
+    return;
+  }
+  sound->queue[head & (SOUND_QUEUE_SIZE - 1)] = id;
+  SDL_AtomicSet(&sound->head, head + 1);
+}
+
+void freeSound(GameState *state) {
+  Sound *sound = &state->sound;
+  if (sound->device)
+    SDL_CloseAudioDevice(sound->device);
+  sound->device = 0;
+
+  for (uint i = 0; i < SOUND_COUNT; i++) {
+    free(sound->samples[i].samples);
+    sound->samples[i] = (Sample){0};
+  }
+  if (sound->dropped)
+    printf("Dropped %u sounds, the queue was full\n", sound->dropped);
+}
@@ -0,0 +1,10 @@
+#ifndef SOUND_H
+#define SOUND_H
+
+#include "gameState.h"
+
+void initSound(GameState *state);
+void playSound(GameState *state, const SoundId id);
+void freeSound(GameState *state);
+
+#endif
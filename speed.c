@@ -0,0 +1,88 @@
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gameState.h"
+#include "speed.h"
+#include "utils.h"
+
+// Share of the frame budget the ticks may take when running as fast as
+// possible, in quarters like the scheduler thresholds, the rest is left
+// for drawing
+#define SIMULATION_SHARE 2
+
+void initSpeed(GameState *state) {
+  Speed *speed = &state->speed;
+  *speed = (Speed){.multiplier = DEFAULT_FAST_FORWARD};
+  speed->start = speed->measureStart = SDL_GetTicks();
+}
+
+// Starts fast forwarding, Tab toggles it afterwards
+// @param multiplier: From 2 to MAX_FAST_FORWARD, or max for as many ticks
+// as fit in each frame
+void setFastForward(GameState *state, const char *multiplier) {
+  Speed *speed = &state->speed;
+  const int value = atoi(multiplier);
+
+  if (!strcmp(multiplier, "max"))
+    speed->multiplier = 0;
+  else if (value >= 2 && value <= MAX_FAST_FORWARD)
+    speed->multiplier = value;
+  else {
+    printf("Fast forward goes from 2 to %d times, or max\n", MAX_FAST_FORWARD);
+    quit(state, 1);
+  }
+  speed->fastForward = true;
+}
+
+void toggleFastForward(GameState *state) {
+  state->speed.fastForward = !state->speed.fastForward;
+}
+
+// @return How many times the tick rate the world runs at, 0 when it runs
+// as fast as possible
+uint tickMultiplier(const GameState *state) {
+  return state->speed.fastForward ? state->speed.multiplier : 1;
+}
+
+// Whether another tick fits in this frame when running as fast as possible
+bool simulationTimeLeft(const GameState *state) {
+  const Scheduler *scheduler = &state->scheduler;
+  const Uint64 budget = scheduler->budget
+                          ? scheduler->budget
+                          : SDL_GetPerformanceFrequency() / TICK_RATE;
+  return (SDL_GetPerformanceCounter() - scheduler->frameStart) * 4 <
+         budget * SIMULATION_SHARE;
+}
+
+// Counts the ticks simulated in a frame, the ticks per second get measured
+// once a second
+void countTicks(GameState *state, const uint ticks) {
+  Speed *speed = &state->speed;
+  const Uint32 now = SDL_GetTicks();
+  speed->ticks += ticks;
+  speed->totalTicks += ticks;
+  if (now - speed->measureStart < 1000)
+    return;
+
+  speed->ticksPerSecond = speed->ticks * 1000 / (now - speed->measureStart);
+  if (speed->ticksPerSecond > speed->peakTicksPerSecond)
+    speed->peakTicksPerSecond = speed->ticksPerSecond;
+  speed->ticks = 0;
+  speed->measureStart = now;
+}
+
+void printSpeed(GameState *state) {
+  const Speed *speed = &state->speed;
+  const Uint32 elapsed = SDL_GetTicks() - speed->start;
+  if (!speed->totalTicks || !elapsed)
+    return;
+
+  const double average = speed->totalTicks * 1000.0 / elapsed;
+  printf("Simulated %llu ticks in %.1f s: %.0f ticks per second on average "
+         "(%.1fx), %u at most\n",
+         (unsigned long long)speed->totalTicks,
+         elapsed / 1000.0,
+         average,
+         average / TICK_RATE,
+         speed->peakTicksPerSecond);
+}
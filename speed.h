@@ -0,0 +1,14 @@
+#ifndef SPEED_H
+#define SPEED_H
+
+#include "gameState.h"
+
+void initSpeed(GameState *state);
+void setFastForward(GameState *state, const char *multiplier);
+void toggleFastForward(GameState *state);
+uint tickMultiplier(const GameState *state);
+bool simulationTimeLeft(const GameState *state);
+void countTicks(GameState *state, const uint ticks);
+void printSpeed(GameState *state);
+
+#endif
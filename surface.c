@@ -0,0 +1,297 @@
+#include <SDL2/SDL.h>
+#include <math.h>
+#include "gameState.h"
+#include "surface.h"
+#include "utils.h"
+
+// Regions merge when that redraws less than a tile of extra pixels
+#define MERGE_SLACK (NATIVE_TILE * NATIVE_TILE)
+
+// Creates the native resolution frame and a software renderer that draws
+// into it. The frame takes the pixel format of the window, so presenting
+// it is a plain copy.
+void initSurfaceBackend(GameState *state) {
+  SurfaceBackend *surface = &state->surface;
+  SDL_Surface *window = SDL_GetWindowSurface(state->window);
+  if (!window) {
+    printf("Could not get the window surface! SDL_Error: %s\n",
+           SDL_GetError());
+    quit(state, 1);
+  }
+
+  surface->frame = SDL_CreateRGBSurfaceWithFormat(0,
+                                                  state->screen.w,
+                                                  state->screen.h,
+                                                  window->format->BitsPerPixel,
+                                                  window->format->format);
+  if (!surface->frame) {
+    printf("Could not create the frame! SDL_Error: %s\n", SDL_GetError());
+    quit(state, 1);
+  }
+  // Formats with alpha would blend the frame into the window otherwise
+  SDL_SetSurfaceBlendMode(surface->frame, SDL_BLENDMODE_NONE);
+
+  state->renderer = SDL_CreateSoftwareRenderer(surface->frame);
+  if (!state->renderer) {
+    printf("Software renderer could not be created! SDL_Error: %s\n",
+           SDL_GetError());
+    quit(state, 1);
+  }
+  surface->enabled = true;
+  surface->full = surface->repaint = true;
+}
+
+// @param variant: Anything else that changes the looks, like a flip
+// @return A key that only matches sprites drawn the same way
+Uint64 spriteKey(const void *texture,
+                 const SDL_Rect *src,
+                 const Uint32 variant) {
+  const Uint64 words[] = {
+    (uintptr_t)texture,
+    src ? (Uint64)(Uint32)src->x << 32 | (Uint32)src->y : 0,
+    src ? (Uint64)(Uint32)src->w << 32 | (Uint32)src->h : 0,
+    variant};
+
+  // FNV-1a
+  Uint64 hash = 0xcbf29ce484222325;
+  const Uint8 *bytes = (const Uint8 *)words;
+  for (size_t i = 0; i < sizeof(words); i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+// The pixels a rectangle touches at all
+static SDL_Rect outerRect(const SDL_FRect *rect) {
+  const int x = floorf(rect->x), y = floorf(rect->y);
+  return (SDL_Rect){
+    x, y, ceilf(rect->x + rect->w) - x, ceilf(rect->y + rect->h) - y};
+}
+
+static int area(const SDL_Rect *rect) {
+  return rect->w * rect->h;
+}
+
+// Adds a region to redraw, merged with every region it overlaps or nearly
+// touches so no pixel gets redrawn twice
+static void addDirty(SurfaceBackend *surface,
+                     SDL_Rect rect,
+                     const SDL_Rect *screen) {
+  if (!SDL_IntersectRect(&rect, screen, &rect))
+    return;
+
+  for (uint i = 0; i < surface->dirtyCount;) {
+    const SDL_Rect *dirty = &surface->dirty[i];
+    SDL_Rect merged;
+    SDL_UnionRect(dirty, &rect, &merged);
+    if (!SDL_HasIntersection(dirty, &rect) &&
+        area(&merged) > area(dirty) + area(&rect) + MERGE_SLACK) {
+      i++;
+      continue;
+    }
+
+    // The merged region can reach the ones checked already
+    rect = merged;
+    surface->dirty[i] = surface->dirty[--surface->dirtyCount];
+    i = 0;
+  }
+
+  if (surface->dirtyCount == MAX_DIRTY_RECTS) {
+    // Out of regions, it goes into the one it grows the least
+    uint closest = 0;
+    int leastGrowth = INT32_MAX;
+    for (uint i = 0; i < surface->dirtyCount; i++) {
+      SDL_Rect merged;
+      SDL_UnionRect(&surface->dirty[i], &rect, &merged);
+      const int growth = area(&merged) - area(&surface->dirty[i]);
+      if (growth < leastGrowth) {
+        leastGrowth = growth;
+        closest = i;
+      }
+    }
+    SDL_UnionRect(&surface->dirty[closest], &rect, &rect);
+    surface->dirty[closest] = surface->dirty[--surface->dirtyCount];
+    addDirty(surface, rect, screen);
+    return;
+  }
+  surface->dirty[surface->dirtyCount++] = rect;
+}
+
+// Starts a pass over the frame that only records where each sprite goes
+// @return false when the surface backend is off, there is nothing to trace
+bool beginSurfaceTrace(GameState *state) {
+  SurfaceBackend *surface = &state->surface;
+  if (!surface->enabled)
+    return false;
+
+  surface->current ^= 1;
+  surface->spriteCount[surface->current] = 0;
+  surface->tracing = true;
+  return true;
+}
+
+// Records where a sprite is drawn this frame, only while tracing
+// @param key: What the sprite looks like, see spriteKey()
+void traceSprite(GameState *state, const SDL_FRect *bounds, const Uint64 key) {
+  SurfaceBackend *surface = &state->surface;
+  if (!surface->tracing)
+    return;
+
+  uint *count = &surface->spriteCount[surface->current];
+  if (*count == MAX_SURFACE_SPRITES) {
+    surface->full = true;
+    return;
+  }
+  surface->sprites[surface->current][(*count)++] =
+    (TracedSprite){outerRect(bounds), key};
+}
+
+// Compares the sprites of this frame with the last one, in drawing order.
+// A sprite that moved or changed dirties both where it was and where it is
+// now, and so does one that appeared or went away.
+void endSurfaceTrace(GameState *state) {
+  SurfaceBackend *surface = &state->surface;
+  const SDL_Rect screen = {0, 0, state->screen.w, state->screen.h};
+  const TracedSprite *now = surface->sprites[surface->current],
+                     *last = surface->sprites[surface->current ^ 1];
+  const uint nowCount = surface->spriteCount[surface->current],
+             lastCount = surface->spriteCount[surface->current ^ 1];
+
+  surface->tracing = false;
+  surface->dirtyCount = 0;
+  if (surface->full) {
+    surface->full = false;
+    surface->dirty[surface->dirtyCount++] = screen;
+    return;
+  }
+
+  for (uint i = 0; i < nowCount || i < lastCount; i++) {
+    if (i < nowCount && i < lastCount && now[i].key == last[i].key &&
+        now[i].bounds.x == last[i].bounds.x &&
+        now[i].bounds.y == last[i].bounds.y &&
+        now[i].bounds.w == last[i].bounds.w &&
+        now[i].bounds.h == last[i].bounds.h)
+      continue;
+
+    if (i < lastCount)
+      addDirty(surface, last[i].bounds, &screen);
+    if (i < nowCount)
+      addDirty(surface, now[i].bounds, &screen);
+  }
+}
+
+// Goes through the regions to redraw that a sprite touches, clipping the
+// renderer to each, draw the sprite once per true returned. With the
+// surface backend off it is true once and nothing is clipped, while tracing
+// it is never true.
+// @param cursor: Starts at 0, keeps the place between calls
+bool clipSprite(GameState *state, const SDL_FRect *bounds, uint *cursor) {
+  SurfaceBackend *surface = &state->surface;
+  if (!surface->enabled)
+    return (*cursor)++ == 0;
+  if (surface->tracing)
+    return false;
+
+  const SDL_Rect rect = outerRect(bounds);
+  while (*cursor < surface->dirtyCount) {
+    const SDL_Rect *dirty = &surface->dirty[(*cursor)++];
+    if (SDL_HasIntersection(dirty, &rect)) {
+      SDL_RenderSetClipRect(state->renderer, dirty);
+      return true;
+    }
+  }
+  SDL_RenderSetClipRect(state->renderer, NULL);
+  return false;
+}
+
+// Call this when something was drawn without being traced, the whole
+// frame is presented now and redrawn on the next one
+void invalidateSurface(GameState *state) {
+  state->surface.full = state->surface.repaint = true;
+}
+
+static void countPixels(SurfaceBackend *surface, const uint pixels) {
+  surface->frames++;
+  surface->pixels += pixels;
+  surface->lastPixels = pixels;
+  if (pixels > surface->peakPixels)
+    surface->peakPixels = pixels;
+  if (!pixels)
+    surface->idleFrames++;
+}
+
+// Copies the regions redrawn this frame to the window surface, upscaled by
+// the largest integer factor that fits and centered, and presents only
+// those
+void presentSurface(GameState *state) {
+  SurfaceBackend *surface = &state->surface;
+  SDL_Surface *window = SDL_GetWindowSurface(state->window);
+  if (!window) {
+    printf("Could not get the window surface! SDL_Error: %s\n",
+           SDL_GetError());
+    quit(state, 1);
+  }
+
+  const int w = surface->frame->w, h = surface->frame->h;
+  const int xscale = window->w / w, yscale = window->h / h;
+  int scale = xscale < yscale ? xscale : yscale;
+  if (scale < 1)
+    scale = 1;
+  const int x = (window->w - w * scale) / 2, y = (window->h - h * scale) / 2;
+
+  // A resized window gets a new surface, with nothing in it yet
+  if (surface->repaint || window->w != surface->windowW ||
+      window->h != surface->windowH) {
+    surface->repaint = false;
+    surface->windowW = window->w;
+    surface->windowH = window->h;
+    SDL_Rect dst = {x, y, w * scale, h * scale};
+    SDL_FillRect(window, NULL, SDL_MapRGB(window->format, 0, 0, 0));
+    SDL_BlitScaled(surface->frame, NULL, window, &dst);
+    SDL_UpdateWindowSurface(state->window);
+    countPixels(surface, window->w * window->h);
+    return;
+  }
+
+  SDL_Rect rects[MAX_DIRTY_RECTS];
+  uint pixels = 0;
+  for (uint i = 0; i < surface->dirtyCount; i++) {
+    const SDL_Rect *dirty = &surface->dirty[i];
+    rects[i] = (SDL_Rect){x + dirty->x * scale,
+                          y + dirty->y * scale,
+                          dirty->w * scale,
+                          dirty->h * scale};
+    // The blit clips its destination in place
+    SDL_Rect dst = rects[i];
+    SDL_BlitScaled(surface->frame, dirty, window, &dst);
+    pixels += area(&rects[i]);
+  }
+  if (surface->dirtyCount)
+    SDL_UpdateWindowSurfaceRects(state->window, rects, surface->dirtyCount);
+  countPixels(surface, pixels);
+}
+
+void printSurfaceBackend(GameState *state) {
+  const SurfaceBackend *surface = &state->surface;
+  if (!surface->frames)
+    return;
+
+  const double average = (double)surface->pixels / surface->frames;
+  const uint windowPixels = surface->windowW * surface->windowH;
+  printf("Window surface: %.0f pixels presented per frame on average "
+         "(%.1f%% of the window), %u at most\n",
+         average,
+         windowPixels ? average * 100 / windowPixels : 0.0,
+         surface->peakPixels);
+  printf("  %u of %u frames presented nothing\n",
+         surface->idleFrames,
+         surface->frames);
+}
+
+// Call this after the renderer that draws into the frame is destroyed
+void freeSurfaceBackend(GameState *state) {
+  if (state->surface.frame)
+    SDL_FreeSurface(state->surface.frame);
+  state->surface.frame = NULL;
+}
@@ -0,0 +1,19 @@
+#ifndef SURFACE_H
+#define SURFACE_H
+
+#include "gameState.h"
+
+void initSurfaceBackend(GameState *state);
+Uint64 spriteKey(const void *texture,
+                 const SDL_Rect *src,
+                 const Uint32 variant);
+bool beginSurfaceTrace(GameState *state);
+void traceSprite(GameState *state, const SDL_FRect *bounds, const Uint64 key);
+void endSurfaceTrace(GameState *state);
+bool clipSprite(GameState *state, const SDL_FRect *bounds, uint *cursor);
+void invalidateSurface(GameState *state);
+void presentSurface(GameState *state);
+void printSurfaceBackend(GameState *state);
+void freeSurfaceBackend(GameState *state);
+
+#endif
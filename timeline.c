@@ -0,0 +1,73 @@
+#include <SDL2/SDL.h>
+#include "animation.h"
+#include "gameState.h"
+#include "timeline.h"
+
+static const SequenceFunc sequences[SEQUENCE_TYPES] = {
+  [SEQUENCE_TRANSFORM] = transformSequence,
+  [SEQUENCE_STAR] = starSequence,
+  [SEQUENCE_FIRING] = firingSequence,
+  [SEQUENCE_BUMP] = bumpSequence,
+  [SEQUENCE_COIN] = coinSequence,
+  [SEQUENCE_HURT] = hurtSequence,
+};
+
+// Starts a sequence, or restarts it from the top if it is already running
+// for the same target
+// @param index: Tells apart sequences of one target, like its coins
+// @return false if every slot is taken, the sequence is dropped then
+bool startSequence(World *world,
+                   const SequenceType type,
+                   const ushort target,
+                   const ushort index) {
+  Sequence *slot = NULL;
+  for (uint i = 0; i < MAX_SEQUENCES; i++) {
+    Sequence *sequence = &world->sequences[i];
+    if (sequence->type == type && sequence->target == target &&
+        sequence->index == index) {
+      slot = sequence;
+      break;
+    }
+    if (!sequence->type && !slot)
+      slot = sequence;
+  }
+  if (!slot)
+    return false;
+
+  *slot = (Sequence){.type = type, .target = target, .index = index};
+  return true;
+}
+
+// Stops every running sequence of a type
+void stopSequences(World *world, const SequenceType type) {
+  for (uint i = 0; i < MAX_SEQUENCES; i++) {
+    if (world->sequences[i].type == type)
+      world->sequences[i] = (Sequence){0};
+  }
+}
+
+// @return The ticks a sequence has been running for, 0 if it is not
+uint sequenceTicks(const World *world,
+                   const SequenceType type,
+                   const ushort target) {
+  for (uint i = 0; i < MAX_SEQUENCES; i++) {
+    const Sequence *sequence = &world->sequences[i];
+    if (sequence->type == type && sequence->target == target)
+      return sequence->ticks;
+  }
+  return 0;
+}
+
+// Advances every running sequence by one tick, in slot order
+void runSequences(GameState *state) {
+  for (uint i = 0; i < MAX_SEQUENCES; i++) {
+    Sequence *sequence = &state->world.sequences[i];
+    if (!sequence->type)
+      continue;
+
+    if (sequences[sequence->type](state, sequence))
+      sequence->ticks++;
+    else
+      *sequence = (Sequence){0};
+  }
+}
@@ -0,0 +1,54 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include "gameState.h"
+
+// Sequences are stackless coroutines: a function that runs once per tick
+// and resumes where it last yielded, its place is kept in the Sequence so
+// the world stays a flat copy. Locals do not survive a yield, keep what
+// must last in the world. Returns true while the sequence keeps going.
+// Every yield and wait is numbered by hand, from 1 up and never reused in
+// a function, since snapshots and history files keep the number. Renumber
+// them only together with HISTORY_VERSION.
+typedef bool (*SequenceFunc)(GameState *state, Sequence *sequence);
+
+#define SEQUENCE_BEGIN(sequence)                                               \
+  switch ((sequence)->step) {                                                  \
+    case 0:
+
+// Gives up the rest of the tick, resuming right here on the next one
+#define SEQUENCE_YIELD(sequence, number)                                       \
+  do {                                                                         \
+    (sequence)->step = (number);                                               \
+    return true;                                                               \
+    case (number):;                                                            \
+  } while (0)
+
+// Resumes after the given number of ticks
+#define SEQUENCE_WAIT(sequence, number, ticks)                                 \
+  do {                                                                         \
+    (sequence)->wait = (ticks);                                                \
+    (sequence)->step = (number);                                               \
+    __attribute__((fallthrough));                                              \
+    case (number):                                                             \
+      if ((sequence)->wait) {                                                  \
+        (sequence)->wait--;                                                    \
+        return true;                                                           \
+      }                                                                        \
+  } while (0)
+
+#define SEQUENCE_END(sequence)                                                 \
+  }                                                                            \
+  return false
+
+bool startSequence(World *world,
+                   const SequenceType type,
+                   const ushort target,
+                   const ushort index);
+void stopSequences(World *world, const SequenceType type);
+uint sequenceTicks(const World *world,
+                   const SequenceType type,
+                   const ushort target);
+void runSequences(GameState *state);
+
+#endif
@@ -1,24 +1,65 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
+#include "assets.h"
+#include "capture.h"
 #include "gameState.h"
+#include "history.h"
+#include "idle.h"
+#include "hud.h"
+#include "jobs.h"
+#include "latency.h"
+#include "layer.h"
+#include "memory.h"
+#include "net.h"
+#include "replay.h"
+#include "scheduler.h"
+#include "sound.h"
+#include "speed.h"
+#include "surface.h"
+#include "watch.h"
 
 // Destroy everything that was initialized from SDL then exit the program.
 // @param *state: Your instance of GameState
 // @param __status: The status shown after exting
 void quit(GameState *state, int __status) {
   Sheets *sheets = &state->sheets;
+  printMemory(state);
+  stopCapture(state);
+  freeSound(state);
+  freeJobs(&state->jobs);
+  freeAssets(state);
+  freeWatcher(state);
+  freeNet(state);
+  free(state->level);
+  freeStaticLayer(state);
+  freeHud(state);
   if (sheets->effects)
     SDL_DestroyTexture(sheets->effects);
   if (sheets->mario)
     SDL_DestroyTexture(sheets->mario);
+  if (sheets->marioMirrored)
+    SDL_DestroyTexture(sheets->marioMirrored);
   if (sheets->objs)
     SDL_DestroyTexture(sheets->objs);
   if (sheets->items)
     SDL_DestroyTexture(sheets->items);
+  if (state->target)
+    SDL_DestroyTexture(state->target);
   if (state->renderer)
     SDL_DestroyRenderer(state->renderer);
+  freeSurfaceBackend(state);
   if (state->window)
     SDL_DestroyWindow(state->window);
+  free(state->snapshots.frames);
+  closeHistoryWriter(&state->history);
+  closeReplay(&state->replay);
+  printLatency(state);
+  printScheduler(state);
+  printSurfaceBackend(state);
+  printSpeed(state);
+  printIdle(state);
+  printNet(state);
+  freeArenas(state);
   IMG_Quit();
   SDL_Quit();
   exit(__status);
@@ -71,3 +112,17 @@ char *catpath(GameState *state, const char *path, const char *file) {
   strcat(result, file);
   return result;
 }
+
+// Concatenates the path and file strings in the scratch arena
+// @return The string, which only lives until the end of the frame
+char *scratchPath(GameState *state, const char *path, const char *file) {
+  const size_t length = strlen(path), fileLength = strlen(file);
+  char *result = arenaAlloc(&state->memory.scratch, length + fileLength + 1);
+  if (result == NULL) {
+    printf("The scratch arena is too small for the file path\n");
+    quit(state, 1);
+  }
+  memcpy(result, path, length);
+  memcpy(result + length, file, fileLength + 1);
+  return result;
+}
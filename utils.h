@@ -22,5 +22,6 @@ void getsrcs(SDL_Rect srcs[],
 // @return Concatenation of the path string and file string
 // @note Free the string after using it
 char *catpath(GameState *state, const char *path, const char *file);
+char *scratchPath(GameState *state, const char *path, const char *file);
 
 #endif
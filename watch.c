@@ -0,0 +1,104 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_timer.h>
+#include <string.h>
+#include "assets.h"
+#include "gameState.h"
+#include "level.h"
+#include "utils.h"
+#include "watch.h"
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Only finished files, so a half written one is never read
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO)
+
+// Starts watching the sprites directory and the directory of the level.
+// Hot reloading only works on Linux, elsewhere this does nothing.
+void initWatcher(GameState *state) {
+  Watcher *watcher = &state->watcher;
+  watcher->fd = watcher->sprites = watcher->level = -1;
+#ifdef __linux__
+  watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (watcher->fd < 0) {
+    printf("Could not start watching the assets, hot reload is off\n");
+    return;
+  }
+
+  watcher->sprites = inotify_add_watch(watcher->fd, SPRITES_PATH, WATCH_EVENTS);
+
+  // The directory, since editors often replace the file instead of writing it
+  char *dir = catpath(state, state->level, "");
+  char *slash = strrchr(dir, '/');
+  if (slash)
+    slash[1] = '\0';
+  watcher->level =
+    inotify_add_watch(watcher->fd, slash ? dir : ".", WATCH_EVENTS);
+  free(dir);
+
+  if (watcher->sprites < 0 || watcher->level < 0)
+    printf("Could not watch some of the assets, they will not hot reload\n");
+#endif
+}
+
+// Reloads whatever changed since the last call. Call it between ticks, a
+// new level replaces the old one in place and keeps the player. Sprites
+// still reload in a network game, the level does not.
+void pollWatcher(GameState *state) {
+#ifdef __linux__
+  Watcher *watcher = &state->watcher;
+  char buffer[4096]
+    __attribute__((aligned(__alignof__(struct inotify_event))));
+  bool levelChanged = false;
+  ssize_t length;
+
+  if (watcher->fd < 0)
+    return;
+
+  while ((length = read(watcher->fd, buffer, sizeof(buffer))) > 0) {
+    for (char *p = buffer; p < buffer + length;) {
+      const struct inotify_event *event = (const struct inotify_event *)p;
+      p += sizeof(struct inotify_event) + event->len;
+      if (!event->len)
+        continue;
+
+      if (event->wd == watcher->sprites) {
+        const char *path = scratchPath(state, SPRITES_PATH, event->name);
+        if (reloadAsset(state, path))
+          printf("Reloading %s\n", path);
+      }
+
+      const char *slash = strrchr(state->level, '/');
+      const char *name = slash ? slash + 1 : state->level;
+      if (event->wd == watcher->level && !strcmp(event->name, name))
+        levelChanged = true;
+    }
+  }
+
+  if (!levelChanged)
+    return;
+  // Each side would reload on a tick of its own, leaving the worlds apart
+  if (state->net.enabled) {
+    printf("Not reloading %s during a network game\n", state->level);
+    return;
+  }
+
+  const Uint64 start = SDL_GetPerformanceCounter();
+  if (loadLevel(state, state->level))
+    printf("Reloaded %s in %.3f ms\n",
+           state->level,
+           (SDL_GetPerformanceCounter() - start) * 1e3 /
+             SDL_GetPerformanceFrequency());
+#else
+  (void)state;
+#endif
+}
+
+void freeWatcher(GameState *state) {
+#ifdef __linux__
+  if (state->watcher.fd >= 0)
+    close(state->watcher.fd);
+#endif
+  state->watcher.fd = -1;
+}
@@ -0,0 +1,10 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include "gameState.h"
+
+void initWatcher(GameState *state);
+void pollWatcher(GameState *state);
+void freeWatcher(GameState *state);
+
+#endif